@@ -0,0 +1,199 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__) && !defined(BIGINTEGER_PORTABLE_LIMBS)
+#include <immintrin.h>
+#define BIGINTEGER_X86_LIMBS 1
+#endif
+#if defined(__has_builtin) && !defined(BIGINTEGER_PORTABLE_LIMBS)
+#if __has_builtin(__builtin_addcll) && __has_builtin(__builtin_subcll)
+#define BIGINTEGER_CARRY_BUILTINS 1
+#endif
+#endif
+
+// Kernels on little-endian arrays of 64-bit limbs, the building blocks of a binary BigInteger:
+// every limb holds 64 bits of the magnitude and a carry is a single bit, never a division.
+// Add and subtract follow the hardware carry chain (__builtin_addcll where the compiler has it,
+// _addcarry_u64 on x86-64). The multiply-accumulate row uses mulx with two independent carry
+// chains (adcx and adox) when the CPU reports BMI2 and ADX at run time. Defining
+// BIGINTEGER_PORTABLE_LIMBS before the include selects plain 128-bit arithmetic everywhere.
+// Unless stated otherwise n >= 1, and r may coincide with an input but not overlap it partially.
+
+typedef uint64_t Limb;
+__extension__ typedef unsigned __int128 DoubleLimb;
+
+// r = a + b; returns the carry out.
+inline Limb addLimbs(Limb* r, const Limb* a, const Limb* b, size_t n){
+#if defined(BIGINTEGER_CARRY_BUILTINS)
+    unsigned long long carry = 0;
+    for(size_t i = 0; i < n; ++i){
+        r[i] = __builtin_addcll(a[i], b[i], carry, &carry);
+    }
+    return carry;
+#elif defined(BIGINTEGER_X86_LIMBS)
+    unsigned char carry = 0;
+    for(size_t i = 0; i < n; ++i){
+        unsigned long long sum;
+        carry = _addcarry_u64(carry, a[i], b[i], &sum);
+        r[i] = sum;
+    }
+    return carry;
+#else
+    Limb carry = 0;
+    for(size_t i = 0; i < n; ++i){
+        Limb sum = a[i] + carry;
+        carry = sum < carry;
+        r[i] = sum + b[i];
+        carry += r[i] < sum;
+    }
+    return carry;
+#endif
+}
+
+// r = a - b; returns the borrow out.
+inline Limb subLimbs(Limb* r, const Limb* a, const Limb* b, size_t n){
+#if defined(BIGINTEGER_CARRY_BUILTINS)
+    unsigned long long borrow = 0;
+    for(size_t i = 0; i < n; ++i){
+        r[i] = __builtin_subcll(a[i], b[i], borrow, &borrow);
+    }
+    return borrow;
+#elif defined(BIGINTEGER_X86_LIMBS)
+    unsigned char borrow = 0;
+    for(size_t i = 0; i < n; ++i){
+        unsigned long long difference;
+        borrow = _subborrow_u64(borrow, a[i], b[i], &difference);
+        r[i] = difference;
+    }
+    return borrow;
+#else
+    Limb borrow = 0;
+    for(size_t i = 0; i < n; ++i){
+        Limb subtrahend = b[i] + borrow;
+        borrow = (subtrahend < borrow) | (a[i] < subtrahend);
+        r[i] = a[i] - subtrahend;
+    }
+    return borrow;
+#endif
+}
+
+// r = a + b for a single limb b, n may be 0; returns the carry out.
+inline Limb addLimb(Limb* r, const Limb* a, size_t n, Limb b){
+    for(size_t i = 0; i < n; ++i){
+        r[i] = a[i] + b;
+        b = r[i] < b;
+    }
+    return b;
+}
+
+// r = a - b for a single limb b, n may be 0; returns the borrow out.
+inline Limb subLimb(Limb* r, const Limb* a, size_t n, Limb b){
+    for(size_t i = 0; i < n; ++i){
+        Limb difference = a[i] - b;
+        b = a[i] < b;
+        r[i] = difference;
+    }
+    return b;
+}
+
+// r = a * b; returns the high limb.
+inline Limb mulLimb(Limb* r, const Limb* a, size_t n, Limb b){
+    Limb carry = 0;
+    for(size_t i = 0; i < n; ++i){
+        DoubleLimb product = DoubleLimb(a[i]) * b + carry;
+        r[i] = static_cast<Limb>(product);
+        carry = static_cast<Limb>(product >> 64);
+    }
+    return carry;
+}
+
+// r += a * b; returns the high limb. a * b + r[i] + carry never exceeds 128 bits.
+inline Limb addMulLimbPortable(Limb* r, const Limb* a, size_t n, Limb b){
+    Limb carry = 0;
+    for(size_t i = 0; i < n; ++i){
+        DoubleLimb product = DoubleLimb(a[i]) * b + r[i] + carry;
+        r[i] = static_cast<Limb>(product);
+        carry = static_cast<Limb>(product >> 64);
+    }
+    return carry;
+}
+
+#ifdef BIGINTEGER_X86_LIMBS
+// The same row with the low half of each product going through the CF chain (adding the
+// previous high half) and the OF chain (adding r[i]), so neither add waits for the other.
+// The loop counter lives in rcx and is tested with jrcxz, which leaves both flags alone.
+__attribute__((target("bmi2,adx"))) inline Limb addMulLimbAdx(Limb* r, const Limb* a, size_t n, Limb b){
+    Limb low, high, carry;
+    asm volatile(
+        "xorl %k[carry], %k[carry]\n\t"
+        "1:\n\t"
+        "mulxq (%[a]), %[low], %[high]\n\t"
+        "adcxq %[carry], %[low]\n\t"
+        "adoxq (%[r]), %[low]\n\t"
+        "movq %[low], (%[r])\n\t"
+        "movq %[high], %[carry]\n\t"
+        "leaq 8(%[a]), %[a]\n\t"
+        "leaq 8(%[r]), %[r]\n\t"
+        "leaq -1(%[n]), %[n]\n\t"
+        "jrcxz 2f\n\t"
+        "jmp 1b\n\t"
+        "2:\n\t"
+        "movl $0, %k[low]\n\t"
+        "adcxq %[low], %[carry]\n\t"
+        "adoxq %[low], %[carry]"
+        : [low] "=&r"(low), [high] "=&r"(high), [carry] "=&r"(carry), [a] "+r"(a), [r] "+r"(r), [n] "+c"(n)
+        : "d"(b)
+        : "cc", "memory");
+    return carry;
+}
+
+inline bool hasAdx(){
+    static const bool supported = __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx");
+    return supported;
+}
+#endif
+
+inline Limb addMulLimb(Limb* r, const Limb* a, size_t n, Limb b){
+#ifdef BIGINTEGER_X86_LIMBS
+    if(hasAdx()){return addMulLimbAdx(r, a, n, b);}
+#endif
+    return addMulLimbPortable(r, a, n, b);
+}
+
+// r = a * b, r holding an + bn limbs and overlapping neither input.
+inline void mulLimbs(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn){
+    r[an] = mulLimb(r, a, an, b[0]);
+#ifdef BIGINTEGER_X86_LIMBS
+    if(hasAdx()){
+        for(size_t j = 1; j < bn; ++j){r[an + j] = addMulLimbAdx(r + j, a, an, b[j]);}
+        return;
+    }
+#endif
+    for(size_t j = 1; j < bn; ++j){r[an + j] = addMulLimbPortable(r + j, a, an, b[j]);}
+}
+
+// q = a / d for d != 0, from the top limb down; returns the remainder. q may equal a.
+inline Limb divLimb(Limb* q, const Limb* a, size_t n, Limb d){
+    Limb remainder = 0;
+    for(size_t i = n; i-- > 0;){
+#ifdef BIGINTEGER_X86_LIMBS
+        // remainder < d, so the quotient fits in one limb and divq cannot fault.
+        Limb low = a[i];
+        asm("divq %[d]" : "+a"(low), "+d"(remainder) : [d] "r"(d) : "cc");
+        q[i] = low;
+#else
+        DoubleLimb dividend = (DoubleLimb(remainder) << 64) | a[i];
+        q[i] = static_cast<Limb>(dividend / d);
+        remainder = static_cast<Limb>(dividend % d);
+#endif
+    }
+    return remainder;
+}
+
+// -1, 0 or 1 as a is less than, equal to or greater than b; n may be 0.
+inline int compareLimbs(const Limb* a, const Limb* b, size_t n){
+    for(size_t i = n; i-- > 0;){
+        if(a[i] != b[i]){return a[i] < b[i] ? -1 : 1;}
+    }
+    return 0;
+}
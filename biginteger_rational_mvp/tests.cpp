@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "limbs.h"
+#include <random>
+#include <vector>
+
+// ---------- Ядра над 64-битными лимбами ----------
+
+static std::vector<Limb> randomLimbs(std::mt19937_64& rng, size_t n){
+    std::vector<Limb> limbs(n);
+    for(Limb& limb : limbs){
+        // Every third limb saturated, so that carries run through long chains.
+        limb = rng() % 3 == 0 ? ~Limb(0) : rng();
+    }
+    return limbs;
+}
+
+TEST(LimbsTest, AddSubCarries) {
+    Limb ones[3] = {~Limb(0), ~Limb(0), ~Limb(0)};
+    Limb one[3] = {1, 0, 0};
+    Limb r[3];
+    EXPECT_EQ(addLimbs(r, ones, one, 3), 1u);
+    EXPECT_EQ(r[0], 0u);
+    EXPECT_EQ(r[2], 0u);
+    EXPECT_EQ(subLimbs(r, r, one, 3), 1u);
+    EXPECT_EQ(compareLimbs(r, ones, 3), 0);
+    EXPECT_EQ(addLimb(r, ones, 3, 5), 1u);
+    EXPECT_EQ(r[0], 4u);
+    EXPECT_EQ(subLimb(r, r, 3, 5), 1u);
+    EXPECT_EQ(compareLimbs(r, ones, 3), 0);
+}
+
+TEST(LimbsTest, AddSubRoundTrip) {
+    std::mt19937_64 rng(45);
+    for(size_t n = 1; n < 40; ++n){
+        std::vector<Limb> a = randomLimbs(rng, n);
+        std::vector<Limb> b = randomLimbs(rng, n);
+        std::vector<Limb> sum(n);
+        std::vector<Limb> back(n);
+        Limb carry = addLimbs(sum.data(), a.data(), b.data(), n);
+        EXPECT_EQ(subLimbs(back.data(), sum.data(), b.data(), n), carry);
+        EXPECT_EQ(back, a);
+        EXPECT_EQ(carry, Limb(compareLimbs(sum.data(), a.data(), n) < 0));
+    }
+}
+
+TEST(LimbsTest, MulMatchesPortable) {
+    std::mt19937_64 rng(46);
+    for(size_t an = 1; an < 20; ++an){
+        for(size_t bn = 1; bn < 20; bn += 3){
+            std::vector<Limb> a = randomLimbs(rng, an);
+            std::vector<Limb> b = randomLimbs(rng, bn);
+            std::vector<Limb> product(an + bn);
+            mulLimbs(product.data(), a.data(), an, b.data(), bn);
+
+            std::vector<Limb> expected(an + bn, 0);
+            for(size_t j = 0; j < bn; ++j){
+                expected[an + j] = addMulLimbPortable(expected.data() + j, a.data(), an, b[j]);
+            }
+            EXPECT_EQ(product, expected);
+
+            std::vector<Limb> accumulated = expected;
+            EXPECT_EQ(addMulLimb(accumulated.data(), a.data(), an, b[0]),
+                      addMulLimbPortable(expected.data(), a.data(), an, b[0]));
+            EXPECT_EQ(accumulated, expected);
+        }
+    }
+}
+
+TEST(LimbsTest, DivLimbInvertsMul) {
+    std::mt19937_64 rng(47);
+    const Limb kTen19 = 10000000000000000000ULL;
+    for(size_t n = 1; n < 20; ++n){
+        std::vector<Limb> a = randomLimbs(rng, n);
+        std::vector<Limb> q(n);
+        Limb remainder = divLimb(q.data(), a.data(), n, kTen19);
+        EXPECT_LT(remainder, kTen19);
+        std::vector<Limb> back(n);
+        EXPECT_EQ(mulLimb(back.data(), q.data(), n, kTen19), 0u);
+        EXPECT_EQ(addLimb(back.data(), back.data(), n, remainder), 0u);
+        EXPECT_EQ(back, a);
+    }
+}
@@ -0,0 +1,263 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Accumulation modes for the solvers in solver.h. A mode is a set of static functions over its
+// Value type; the solvers are templates over the mode, so every mode is compiled into its own
+// loops and the default Wrapping64 costs exactly what plain 64-bit arithmetic does.
+//
+//   Value                          what the solver sums and multiplies
+//   fromInt, addTo, subFrom, mulBy arithmetic, in place so that wide values are not copied;
+//                                  subFrom is only needed by the Ryser formula
+//   isZero                         lets the subset DP skip unreachable states
+//   kRyserSafe                     whether the Ryser formula gives the right result: its
+//                                  alternating intermediate sums must not fail on their own
+//   Result, result(value)          what the caller gets back
+//   toString(result)               decimal form for printing
+
+// Modulo 2^64, reported as long long: exact whenever the final sum fits, whatever the
+// intermediate values do.
+struct Wrapping64{
+	typedef uint64_t Value;
+	typedef long long Result;
+
+	static Value fromInt(long long x){return static_cast<uint64_t>(x);}
+	static void addTo(Value& a, Value b){a += b;}
+	static void subFrom(Value& a, Value b){a -= b;}
+	static void mulBy(Value& a, Value b){a *= b;}
+	static bool isZero(Value a){return a == 0;}
+	static constexpr bool kRyserSafe = true;
+	static Result result(Value a){return static_cast<long long>(a);}
+	static std::string toString(Result a){return std::to_string(a);}
+};
+
+// Signed 64-bit that throws std::overflow_error on the first overflowing operation. For the
+// Ryser formula this would include its intermediate sums, which may overflow for a result that
+// fits, so the automatic choice never uses Ryser in this mode.
+struct Checked64{
+	typedef long long Value;
+	typedef long long Result;
+
+	static Value fromInt(long long x){return x;}
+
+	static void addTo(Value& a, Value b){
+		if(__builtin_add_overflow(a, b, &a)){throw std::overflow_error("64-bit overflow in addition");}
+	}
+
+	static void subFrom(Value& a, Value b){
+		if(__builtin_sub_overflow(a, b, &a)){throw std::overflow_error("64-bit overflow in subtraction");}
+	}
+
+	static void mulBy(Value& a, Value b){
+		if(__builtin_mul_overflow(a, b, &a)){throw std::overflow_error("64-bit overflow in multiplication");}
+	}
+
+	static bool isZero(Value a){return a == 0;}
+	static constexpr bool kRyserSafe = false;
+	static Result result(Value a){return a;}
+	static std::string toString(Result a){return std::to_string(a);}
+};
+
+// Modulo 2^128, reported as signed __int128: enough for the sum of 10^9-sized values with k up
+// to 4, and exact under the same rule as Wrapping64.
+struct Int128{
+	__extension__ typedef unsigned __int128 Value;
+	__extension__ typedef __int128 Result;
+
+	static Value fromInt(long long x){return static_cast<Value>(static_cast<Result>(x));}
+	static void addTo(Value& a, Value b){a += b;}
+	static void subFrom(Value& a, Value b){a -= b;}
+	static void mulBy(Value& a, Value b){a *= b;}
+	static bool isZero(Value a){return a == 0;}
+	static constexpr bool kRyserSafe = true;
+	static Result result(Value a){return static_cast<Result>(a);}
+
+	static std::string toString(Result a){
+		Value magnitude = a < 0 ? 0 - static_cast<Value>(a) : static_cast<Value>(a);
+		std::string digits;
+		do{
+			digits.push_back(static_cast<char>('0' + static_cast<int>(magnitude % 10)));
+			magnitude /= 10;
+		} while(magnitude != 0);
+		if(a < 0){digits.push_back('-');}
+		std::reverse(digits.begin(), digits.end());
+		return digits;
+	}
+};
+
+// Arbitrary precision: sign and magnitude in base 2^32 limbs, least significant first,
+// without leading zero limbs; zero is an empty magnitude and is never negative.
+class ExactInteger{
+private:
+	bool negative_ = false;
+	std::vector<uint32_t> limbs_;
+
+	void trim(){
+		while(!limbs_.empty() && limbs_.back() == 0){limbs_.pop_back();}
+		if(limbs_.empty()){negative_ = false;}
+	}
+
+	static int compareMagnitude(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b){
+		if(a.size() != b.size()){return a.size() < b.size() ? -1 : 1;}
+		for(size_t i = a.size(); i-- > 0;){
+			if(a[i] != b[i]){return a[i] < b[i] ? -1 : 1;}
+		}
+		return 0;
+	}
+
+	static void addMagnitude(std::vector<uint32_t>& a, const std::vector<uint32_t>& b){
+		a.resize(std::max(a.size(), b.size()) + 1, 0);
+		uint64_t carry = 0;
+		for(size_t i = 0; i < a.size(); ++i){
+			if(i >= b.size() && carry == 0){break;}
+			carry += static_cast<uint64_t>(a[i]) + (i < b.size() ? b[i] : 0);
+			a[i] = static_cast<uint32_t>(carry);
+			carry >>= 32;
+		}
+	}
+
+	// result = a - b for |a| >= |b|; result may alias a or b.
+	static void subMagnitude(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, std::vector<uint32_t>& result){
+		size_t size = a.size();
+		result.resize(size, 0);
+		int64_t borrow = 0;
+		for(size_t i = 0; i < size; ++i){
+			int64_t value = static_cast<int64_t>(a[i]) - (i < b.size() ? b[i] : 0) - borrow;
+			borrow = value < 0;
+			result[i] = static_cast<uint32_t>(value + (borrow << 32));
+		}
+	}
+
+public:
+	ExactInteger() = default;
+
+	ExactInteger(long long x): negative_(x < 0){
+		uint64_t magnitude = x < 0 ? 0 - static_cast<uint64_t>(x) : static_cast<uint64_t>(x);
+		limbs_ = {static_cast<uint32_t>(magnitude), static_cast<uint32_t>(magnitude >> 32)};
+		trim();
+	}
+
+	bool isZero() const{
+		return limbs_.empty();
+	}
+
+	ExactInteger operator-() const{
+		ExactInteger result = *this;
+		result.negative_ = !negative_ && !limbs_.empty();
+		return result;
+	}
+
+	ExactInteger& operator+=(const ExactInteger& other){
+		if(negative_ == other.negative_){
+			addMagnitude(limbs_, other.limbs_);
+		} else if(compareMagnitude(limbs_, other.limbs_) >= 0){
+			subMagnitude(limbs_, other.limbs_, limbs_);
+		} else{
+			subMagnitude(other.limbs_, limbs_, limbs_);
+			negative_ = other.negative_;
+		}
+		trim();
+		return *this;
+	}
+
+	ExactInteger& operator-=(const ExactInteger& other){
+		return *this += -other;
+	}
+
+	ExactInteger& operator*=(const ExactInteger& other){
+		std::vector<uint32_t> product(limbs_.size() + other.limbs_.size(), 0);
+		for(size_t i = 0; i < limbs_.size(); ++i){
+			uint64_t carry = 0;
+			for(size_t j = 0; j < other.limbs_.size(); ++j){
+				carry += static_cast<uint64_t>(limbs_[i]) * other.limbs_[j] + product[i + j];
+				product[i + j] = static_cast<uint32_t>(carry);
+				carry >>= 32;
+			}
+			product[i + other.limbs_.size()] = static_cast<uint32_t>(carry);
+		}
+		limbs_ = std::move(product);
+		negative_ = negative_ != other.negative_;
+		trim();
+		return *this;
+	}
+
+	bool operator==(const ExactInteger& other) const{
+		return negative_ == other.negative_ && limbs_ == other.limbs_;
+	}
+
+	bool operator!=(const ExactInteger& other) const{
+		return !(*this == other);
+	}
+
+	std::string toString() const{
+		static constexpr uint32_t kChunk = 1000000000;
+		std::vector<uint32_t> rest = limbs_;
+		std::string digits;
+		while(!rest.empty()){
+			uint64_t remainder = 0;
+			for(size_t i = rest.size(); i-- > 0;){
+				uint64_t current = remainder << 32 | rest[i];
+				rest[i] = static_cast<uint32_t>(current / kChunk);
+				remainder = current % kChunk;
+			}
+			while(!rest.empty() && rest.back() == 0){rest.pop_back();}
+			for(int d = 0; d < 9 && (!rest.empty() || remainder != 0); ++d){
+				digits.push_back(static_cast<char>('0' + remainder % 10));
+				remainder /= 10;
+			}
+		}
+		if(digits.empty()){digits = "0";}
+		if(negative_){digits.push_back('-');}
+		std::reverse(digits.begin(), digits.end());
+		return digits;
+	}
+};
+
+struct Exact{
+	typedef ExactInteger Value;
+	typedef ExactInteger Result;
+
+	static Value fromInt(long long x){return Value(x);}
+	static void addTo(Value& a, const Value& b){a += b;}
+	static void subFrom(Value& a, const Value& b){a -= b;}
+	static void mulBy(Value& a, const Value& b){a *= b;}
+	static bool isZero(const Value& a){return a.isZero();}
+	static constexpr bool kRyserSafe = true;
+	static Result result(const Value& a){return a;}
+	static std::string toString(const Result& a){return a.toString();}
+};
+
+// Modulo the Mersenne prime 2^61 - 1, for verifying large sums by their residue; values are
+// kept reduced to [0, p).
+struct ModPrime{
+	typedef uint64_t Value;
+	typedef uint64_t Result;
+
+	static constexpr uint64_t kModulus = (uint64_t(1) << 61) - 1;
+
+	static Value reduce(uint64_t x){
+		x = (x & kModulus) + (x >> 61);
+		return x >= kModulus ? x - kModulus : x;
+	}
+
+	static Value fromInt(long long x){
+		Value magnitude = reduce(x < 0 ? 0 - static_cast<uint64_t>(x) : static_cast<uint64_t>(x));
+		return x < 0 && magnitude != 0 ? kModulus - magnitude : magnitude;
+	}
+
+	static void addTo(Value& a, Value b){a = reduce(a + b);}
+	static void subFrom(Value& a, Value b){a = reduce(a + kModulus - b);}
+
+	static void mulBy(Value& a, Value b){
+		__extension__ unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+		a = reduce((static_cast<uint64_t>(product) & kModulus) + static_cast<uint64_t>(product >> 61));
+	}
+
+	static bool isZero(Value a){return a == 0;}
+	static constexpr bool kRyserSafe = true;
+	static Result result(Value a){return a;}
+	static std::string toString(Result a){return std::to_string(a);}
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+// k integer arrays of arbitrary sizes in one contiguous allocation: array i occupies
+// values[offsets[i], offsets[i + 1]).
+class Arrays{
+public:
+	class View{
+	private:
+		const int* data_;
+		size_t size_;
+
+	public:
+		View(const int* data, size_t size): data_(data), size_(size){}
+
+		size_t size() const{return size_;}
+		const int& operator[](size_t i) const{return data_[i];}
+		const int* begin() const{return data_;}
+		const int* end() const{return data_ + size_;}
+	};
+
+private:
+	std::vector<int> values_;
+	std::vector<size_t> offsets_{0};
+
+	void append(const std::vector<int>& arr){
+		values_.insert(values_.end(), arr.begin(), arr.end());
+		offsets_.push_back(values_.size());
+	}
+
+public:
+	Arrays() = default;
+
+	Arrays(std::initializer_list<std::vector<int>> arrays){
+		for(const std::vector<int>& arr : arrays){append(arr);}
+	}
+
+	Arrays(const std::vector<std::vector<int>>& arrays){
+		for(const std::vector<int>& arr : arrays){append(arr);}
+	}
+
+	Arrays(size_t count, const std::vector<int>& arr){
+		for(size_t i = 0; i < count; ++i){append(arr);}
+	}
+
+	// Zero-filled arrays of the given sizes, to be filled in place through data().
+	explicit Arrays(const std::vector<size_t>& sizes){
+		offsets_.reserve(sizes.size() + 1);
+		for(size_t size : sizes){offsets_.push_back(offsets_.back() + size);}
+		values_.resize(offsets_.back());
+	}
+
+	size_t size() const{return offsets_.size() - 1;}
+	size_t totalSize() const{return values_.size();}
+
+	int* data(){return values_.data();}
+	const int* data() const{return values_.data();}
+
+	View operator[](size_t i) const{
+		return View(values_.data() + offsets_[i], offsets_[i + 1] - offsets_[i]);
+	}
+};
@@ -0,0 +1,94 @@
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "ingest.h"
+
+// Usage: generate [--bench] [--seed=N] [--max=V] size1 .. sizek
+// Writes k arrays of the given sizes for main, one array per line, with values drawn uniformly
+// from [-V, V] (V defaults to 10^9, at most INT_MAX). The same sizes go to main, so
+//   generate 30000000 > input.txt && main 1 < input.txt
+// times the ingestion of 30 million integers; the parsing rate is printed on stderr by
+//   generate --bench 30000000
+// which parses the generated text in memory with parseInt instead of writing it.
+
+// Non-negative decimal value of an option, reported with the whole option when malformed.
+static size_t optionValue(const char* option, size_t prefix){
+	try{
+		return parseSize(option + prefix);
+	} catch(const std::runtime_error&){
+		throw std::runtime_error(std::string("invalid option '") + option + "'");
+	}
+}
+
+static int run(bool bench, uint64_t seed, int max, const std::vector<size_t>& sizes){
+	std::mt19937_64 rng(seed);
+	std::uniform_int_distribution<int> value(-max, max);
+	std::vector<char> buffer;
+	const size_t kFlushSize = 1 << 20;
+	auto flush = [&](){
+		if(!bench && !buffer.empty()){
+			std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+			buffer.clear();
+		}
+	};
+
+	for(size_t size : sizes){
+		for(size_t j = 0; j < size; ++j){
+			char digits[16];
+			char* end = std::to_chars(digits, digits + sizeof(digits), value(rng)).ptr;
+			buffer.insert(buffer.end(), digits, end);
+			buffer.push_back(j + 1 == size ? '\n' : ' ');
+			if(buffer.size() >= kFlushSize){flush();}
+		}
+		if(size == 0){buffer.push_back('\n');}
+	}
+	flush();
+	if(!bench){return std::fflush(stdout) == 0 ? 0 : 1;}
+
+	auto start = std::chrono::steady_clock::now();
+	const char* p = buffer.data();
+	const char* end = p + buffer.size();
+	long long checksum = 0;
+	while(true){
+		while(p != end && isSpace(*p)){++p;}
+		if(p == end){break;}
+		int parsed;
+		p = parseInt(p, end, parsed);
+		checksum += parsed;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cerr << buffer.size() << " bytes in " << seconds << " s, "
+		<< static_cast<double>(buffer.size()) / seconds / 1e9 << " GB/s (checksum " << checksum << ")\n";
+	return 0;
+}
+
+int main(int argc, char** argv){
+	bool bench = false;
+	uint64_t seed = 42;
+	int max = 1000000000;
+	std::vector<size_t> sizes;
+	try{
+		for(int i = 1; i < argc; ++i){
+			if(std::strcmp(argv[i], "--bench") == 0){
+				bench = true;
+			} else if(std::strncmp(argv[i], "--seed=", 7) == 0){
+				seed = optionValue(argv[i], 7);
+			} else if(std::strncmp(argv[i], "--max=", 6) == 0){
+				size_t bound = optionValue(argv[i], 6);
+				if(bound > INT_MAX){throw std::runtime_error("--max must not exceed INT_MAX");}
+				max = static_cast<int>(bound);
+			} else{
+				sizes.push_back(parseSize(argv[i]));
+			}
+		}
+	} catch(const std::runtime_error& error){
+		std::cerr << error.what() << '\n';
+		return 1;
+	}
+	return run(bench, seed, max, sizes);
+}
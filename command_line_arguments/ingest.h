@@ -0,0 +1,188 @@
+#pragma once
+#include "arrays.h"
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Whitespace-separated decimal integers, each with an optional sign. Anything else, a value
+// outside int, a token of kMaxIntegerLength bytes or more, or too few values is reported with
+// std::runtime_error.
+
+const size_t kMaxIntegerLength = 24;
+
+inline bool isSpace(char c){
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Number of leading decimal digits among the 8 bytes of chunk, first byte lowest. A byte is a
+// digit iff both its high nibble and the high nibble of byte + 6 are 3; the carry out of a
+// non-digit byte only disturbs the bytes after it, which are not counted.
+inline size_t leadingDigits(uint64_t chunk){
+	const uint64_t kHigh = 0xF0F0F0F0F0F0F0F0ULL;
+	const uint64_t kThrees = 0x3030303030303030ULL;
+	uint64_t rejected = ((chunk & kHigh) ^ kThrees) | (((chunk + 0x0606060606060606ULL) & kHigh) ^ kThrees);
+	return rejected == 0 ? 8 : static_cast<size_t>(__builtin_ctzll(rejected)) / 8;
+}
+
+// Value of the first n (1 <= n <= 8) digit bytes of chunk: the digits are moved to the top so
+// that zero bytes fill in as leading zeros, then adjacent pairs, quads and halves are merged.
+inline uint64_t digitsValue(uint64_t chunk, size_t n){
+	chunk = (chunk - 0x3030303030303030ULL) << (8 * (8 - n));
+	chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFULL;
+	chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFULL;
+	return (chunk * 10000 + (chunk >> 32)) & 0xFFFFFFFFULL;
+}
+
+// Parses one integer starting at p, which must not be whitespace, and returns the position
+// after it. Eight digits are taken at a time while at least eight bytes remain before end.
+// Whether a token is too long only depends on its first kMaxIntegerLength bytes, so a reader
+// that keeps that many in view rejects exactly what parsing the whole input would.
+inline const char* parseInt(const char* p, const char* end, int& value){
+	static const uint64_t kPowers[9] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+	const char* start = p;
+	bool negative = false;
+	if(p != end && (*p == '-' || *p == '+')){
+		negative = *p == '-';
+		++p;
+	}
+	const char* digits = p;
+	while(p != end && *p == '0'){++p;}
+
+	uint64_t magnitude = 0;
+	size_t significant = 0;
+	while(end - p >= 8){
+		uint64_t chunk;
+		std::memcpy(&chunk, p, 8);
+		size_t n = leadingDigits(chunk);
+		if(n == 0){break;}
+		magnitude = magnitude * kPowers[n] + digitsValue(chunk, n);
+		p += n;
+		significant += n;
+		if(n < 8 || significant > 10){break;}
+	}
+	while(p != end && *p >= '0' && *p <= '9' && significant <= 10){
+		magnitude = magnitude * 10 + static_cast<uint64_t>(*p - '0');
+		++p;
+		++significant;
+	}
+
+	const ptrdiff_t kMaxLength = static_cast<ptrdiff_t>(kMaxIntegerLength);
+	if(p == digits || (p != end && !isSpace(*p))){
+		const char* stop = start;
+		while(stop != end && !isSpace(*stop) && stop - start < kMaxLength){++stop;}
+		if(stop - start == kMaxLength){throw std::runtime_error("integer too long");}
+		throw std::runtime_error("malformed integer '" + std::string(start, stop) + "'");
+	}
+	if(p - start >= kMaxLength){throw std::runtime_error("integer too long");}
+	if(significant > 10 || magnitude > (negative ? uint64_t(INT_MAX) + 1 : uint64_t(INT_MAX))){
+		throw std::runtime_error("integer out of range");
+	}
+	value = negative ? static_cast<int>(0 - magnitude) : static_cast<int>(magnitude);
+	return p;
+}
+
+// Validated array size from the command line.
+inline size_t parseSize(const char* str){
+	size_t size = 0;
+	if(*str == '\0'){throw std::runtime_error("empty array size");}
+	for(const char* p = str; *p; ++p){
+		if(*p < '0' || *p > '9' || size > (SIZE_MAX - 9) / 10){
+			throw std::runtime_error(std::string("invalid array size '") + str + "'");
+		}
+		size = size * 10 + static_cast<size_t>(*p - '0');
+	}
+	return size;
+}
+
+// Reads integers from a file descriptor: a regular file is mapped whole, anything else is read
+// in large blocks. Before a number is parsed at least kMaxIntegerLength bytes are kept in the
+// buffer (or the input is exhausted), so no token is cut by a block boundary before parseInt
+// has seen enough of it to accept or reject it as it would from a file.
+class IntReader{
+private:
+	static constexpr size_t kBlockSize = 1 << 20;
+
+	int fd_;
+	char* data_ = nullptr;
+	size_t pos_ = 0;
+	size_t end_ = 0;
+	bool mapped_ = false;
+	bool eof_ = false;
+
+	void refill(){
+		std::memmove(data_, data_ + pos_, end_ - pos_);
+		end_ -= pos_;
+		pos_ = 0;
+		while(!eof_ && end_ < kMaxIntegerLength){
+			ssize_t got = ::read(fd_, data_ + end_, kBlockSize - end_);
+			if(got < 0 && errno == EINTR){continue;}
+			if(got < 0){throw std::runtime_error(std::string("read failed: ") + std::strerror(errno));}
+			if(got == 0){eof_ = true;}
+			end_ += static_cast<size_t>(got);
+		}
+	}
+
+public:
+	explicit IntReader(int fd): fd_(fd){
+		struct stat info;
+		if(::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0){
+			void* file = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if(file != MAP_FAILED){
+				::madvise(file, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+				data_ = static_cast<char*>(file);
+				end_ = static_cast<size_t>(info.st_size);
+				mapped_ = true;
+				eof_ = true;
+				return;
+			}
+		}
+		data_ = new char[kBlockSize];
+	}
+
+	IntReader(const IntReader&) = delete;
+	IntReader& operator=(const IntReader&) = delete;
+
+	~IntReader(){
+		if(mapped_){
+			::munmap(data_, end_);
+		} else{
+			delete[] data_;
+		}
+	}
+
+	bool next(int& value){
+		while(true){
+			while(pos_ < end_ && isSpace(data_[pos_])){++pos_;}
+			if(pos_ < end_ || eof_){break;}
+			refill();
+		}
+		if(end_ - pos_ < kMaxIntegerLength && !eof_){refill();}
+		if(pos_ == end_){return false;}
+		pos_ = static_cast<size_t>(parseInt(data_ + pos_, data_ + end_, value) - data_);
+		return true;
+	}
+
+	void read(int* values, size_t count){
+		for(size_t i = 0; i < count; ++i){
+			if(!next(values[i])){
+				throw std::runtime_error("expected " + std::to_string(count) + " integers, got " + std::to_string(i));
+			}
+		}
+	}
+};
+
+// Arrays of the given sizes filled from the reader in order, in one allocation.
+inline Arrays readArrays(IntReader& reader, const std::vector<size_t>& sizes){
+	Arrays arrs(sizes);
+	reader.read(arrs.data(), arrs.totalSize());
+	return arrs;
+}
@@ -1,57 +1,46 @@
+#include <cstring>
 #include <iostream>
-
-int toInt(const char* str){
-	int result = 0;
-
-	while(*str){
-		result = result * 10 + (*str - '0');
-		++str;
-	}
-	return result;
-}
-
-long long dfs(int depth, int k, int** arrs, int* sizes, int* indices, long long current_prod){
-	if(depth == k){return current_prod;}
-	
-	long long sum = 0;
-	for(int i = 0; i < sizes[depth]; ++i){
-		bool flag = true;
-		for(int j = 0; j < depth; ++j){
-			if(indices[j] == i){flag = false; break;}
-		}
-		if(!flag){continue;}
-
-		indices[depth] = i;
-		current_prod *= arrs[depth][i];
-		sum += dfs(depth+1, k, arrs, sizes, indices, current_prod);
+#include "ingest.h"
+#include "solver.h"
+
+template <typename Mode>
+int solve(const Arrays& arrs){
+	try{
+		std::cout << Mode::toString(sumInjectiveProducts<Mode>(arrs));
+	} catch(const std::overflow_error& error){
+		std::cerr << error.what() << '\n';
+		return 1;
 	}
-	return sum;
+	return 0;
 }
 
+// Usage: main [--mode=wrap|checked|int128|exact|mod] size1 .. sizek, arrays on stdin.
 int main(int argc, char** argv){
-	int k = argc - 1;
-	int** arrs = new int*[k];
-	int* sizes = new int[k];
-
-	for(int i = 0; i < k; ++i){
-		sizes[i] = toInt(argv[i + 1]);
-		arrs[i] = new int[sizes[i]];
-		for(int j = 0; j < sizes[i]; ++j){
-			std::cin >> arrs[i][j];
-		}
+	const char* mode = "wrap";
+	int first = 1;
+	if(argc > 1 && std::strncmp(argv[1], "--mode=", 7) == 0){
+		mode = argv[1] + 7;
+		first = 2;
 	}
 
-	int* indices = new int[k];
-	long long result;
-	result = dfs(0, k, arrs, sizes, indices, 1);	
-
-	std::cout << result;
-
-	for(int i = 0; i < k; ++i){
-		delete[] arrs[i];
+	Arrays arrs;
+	try{
+		std::vector<size_t> sizes;
+		for(int i = first; i < argc; ++i){
+			sizes.push_back(parseSize(argv[i]));
+		}
+		IntReader reader(STDIN_FILENO);
+		arrs = readArrays(reader, sizes);
+	} catch(const std::runtime_error& error){
+		std::cerr << error.what() << '\n';
+		return 1;
 	}
 
-	delete[] indices;
-	delete[] sizes;
-	delete[] arrs;
+	if(std::strcmp(mode, "wrap") == 0){return solve<Wrapping64>(arrs);}
+	if(std::strcmp(mode, "checked") == 0){return solve<Checked64>(arrs);}
+	if(std::strcmp(mode, "int128") == 0){return solve<Int128>(arrs);}
+	if(std::strcmp(mode, "exact") == 0){return solve<Exact>(arrs);}
+	if(std::strcmp(mode, "mod") == 0){return solve<ModPrime>(arrs);}
+	std::cerr << "unknown mode " << mode << '\n';
+	return 1;
 }
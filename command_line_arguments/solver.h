@@ -0,0 +1,306 @@
+#pragma once
+#include "accumulation.h"
+#include "arrays.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Sum over every injective choice of indices (one index per array, all distinct) of the product
+// of the chosen elements. Index j may be chosen for array i only when j < arrs[i].size();
+// m below is the index range, the largest array size.
+//
+// Every solver is a template over an accumulation mode from accumulation.h. The default,
+// Wrapping64, accumulates modulo 2^64, so the result is exact whenever it fits in long long,
+// even if intermediate sums of the Ryser formula do not.
+
+enum class Method{
+	Dfs,
+	ParallelDfs,
+	SubsetDp,
+	Ryser
+};
+
+const int kMaxSubsetDpIndices = 24;
+const int kMaxRyserIndices = 40;
+const size_t kDefaultSplitDepth = 2;
+// The subset DP table is never allowed to grow past this many bytes.
+const size_t kMaxSubsetDpBytes = size_t(64) << 20;
+// Below this many DFS steps starting threads costs more than it saves.
+const double kMinParallelDfsCost = 1e5;
+
+inline int indexRange(const Arrays& arrs){
+	size_t m = 0;
+	for(size_t i = 0; i < arrs.size(); ++i){
+		m = std::max(m, arrs[i].size());
+	}
+	return static_cast<int>(m);
+}
+
+inline bool isUsed(const std::vector<uint64_t>& used, size_t i){
+	return used[i >> 6] >> (i & 63) & 1;
+}
+
+inline void flipUsed(std::vector<uint64_t>& used, size_t i){
+	used[i >> 6] ^= uint64_t(1) << (i & 63);
+}
+
+template <typename Mode>
+void dfs(const Arrays& arrs, size_t depth, std::vector<uint64_t>& used, const typename Mode::Value& current_prod, typename Mode::Value& sum){
+	if(depth == arrs.size()){Mode::addTo(sum, current_prod); return;}
+
+	Arrays::View arr = arrs[depth];
+	for(size_t i = 0; i < arr.size(); ++i){
+		if(isUsed(used, i)){continue;}
+
+		flipUsed(used, i);
+		typename Mode::Value prod = current_prod;
+		Mode::mulBy(prod, Mode::fromInt(arr[i]));
+		dfs<Mode>(arrs, depth + 1, used, prod, sum);
+		flipUsed(used, i);
+	}
+}
+
+inline std::vector<uint64_t> usedSet(const Arrays& arrs){
+	return std::vector<uint64_t>((static_cast<size_t>(indexRange(arrs)) + 63) / 64, 0);
+}
+
+// Plain enumeration, O(m^k); the only method without a limit on m.
+template <typename Mode = Wrapping64>
+typename Mode::Result sumDfs(const Arrays& arrs){
+	std::vector<uint64_t> used = usedSet(arrs);
+	typename Mode::Value sum = Mode::fromInt(0);
+	dfs<Mode>(arrs, 0, used, Mode::fromInt(1), sum);
+	return Mode::result(sum);
+}
+
+// Every injective prefix of split_depth indices becomes a task. Tasks are dealt round-robin to
+// per-thread queues; a thread takes its own tasks from the back and, once its queue is empty,
+// steals from the front of the others. Each thread sums into its own slot, and the slots are
+// added up at the end. An exception thrown by the mode stops all threads and is rethrown.
+template <typename Mode = Wrapping64>
+typename Mode::Result sumParallelDfs(const Arrays& arrs, size_t split_depth = kDefaultSplitDepth,
+                                     size_t threads = std::max(1u, std::thread::hardware_concurrency())){
+	typedef typename Mode::Value Value;
+	struct Task{
+		size_t begin;
+		Value prod;
+	};
+	struct alignas(64) Worker{
+		std::mutex mutex;
+		std::deque<size_t> tasks;
+		Value sum = Mode::fromInt(0);
+		std::exception_ptr error;
+	};
+
+	split_depth = std::min(split_depth, arrs.size());
+	std::vector<size_t> prefixes;
+	std::vector<Task> tasks;
+	std::vector<size_t> prefix;
+	std::vector<uint64_t> used = usedSet(arrs);
+	auto collect = [&](auto& self, size_t depth, const Value& prod) -> void{
+		if(depth == split_depth){
+			tasks.push_back({prefixes.size(), prod});
+			prefixes.insert(prefixes.end(), prefix.begin(), prefix.end());
+			return;
+		}
+		for(size_t i = 0; i < arrs[depth].size(); ++i){
+			if(isUsed(used, i)){continue;}
+			flipUsed(used, i);
+			prefix.push_back(i);
+			Value next_prod = prod;
+			Mode::mulBy(next_prod, Mode::fromInt(arrs[depth][i]));
+			self(self, depth + 1, next_prod);
+			prefix.pop_back();
+			flipUsed(used, i);
+		}
+	};
+	collect(collect, 0, Mode::fromInt(1));
+
+	threads = std::max<size_t>(1, std::min(threads, tasks.size()));
+	std::vector<Worker> workers(threads);
+	for(size_t t = 0; t < tasks.size(); ++t){
+		workers[t % threads].tasks.push_back(t);
+	}
+
+	std::atomic<bool> failed{false};
+	auto next = [&](size_t self, size_t& task) -> bool{
+		for(size_t k = 0; k < threads && !failed.load(std::memory_order_relaxed); ++k){
+			Worker& victim = workers[(self + k) % threads];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if(victim.tasks.empty()){continue;}
+			if(k == 0){
+				task = victim.tasks.back();
+				victim.tasks.pop_back();
+			} else{
+				task = victim.tasks.front();
+				victim.tasks.pop_front();
+			}
+			return true;
+		}
+		return false;
+	};
+	auto run = [&](size_t self){
+		std::vector<uint64_t> local_used = usedSet(arrs);
+		Value sum = Mode::fromInt(0);
+		size_t task;
+		try{
+			while(next(self, task)){
+				const size_t* indices = prefixes.data() + tasks[task].begin;
+				for(size_t d = 0; d < split_depth; ++d){flipUsed(local_used, indices[d]);}
+				dfs<Mode>(arrs, split_depth, local_used, tasks[task].prod, sum);
+				for(size_t d = 0; d < split_depth; ++d){flipUsed(local_used, indices[d]);}
+			}
+		} catch(...){
+			workers[self].error = std::current_exception();
+			failed.store(true);
+		}
+		workers[self].sum = sum;
+	};
+
+	std::vector<std::thread> pool;
+	for(size_t t = 1; t < threads; ++t){
+		pool.emplace_back(run, t);
+	}
+	run(0);
+	for(std::thread& thread : pool){
+		thread.join();
+	}
+
+	Value sum = Mode::fromInt(0);
+	for(const Worker& worker : workers){
+		if(worker.error){std::rethrow_exception(worker.error);}
+		Mode::addTo(sum, worker.sum);
+	}
+	return Mode::result(sum);
+}
+
+// dp[mask] is the sum over the ways to give the first popcount(mask) arrays exactly the indices
+// in mask. Masks only grow, so one pass in increasing order is enough: O(m * 2^m) time and
+// 2^m values of memory, for m <= kMaxSubsetDpIndices.
+template <typename Mode = Wrapping64>
+typename Mode::Result sumSubsetDp(const Arrays& arrs){
+	typedef typename Mode::Value Value;
+	size_t k = arrs.size();
+	int m = indexRange(arrs);
+	if(k > static_cast<size_t>(m)){return Mode::result(Mode::fromInt(0));}
+
+	std::vector<Value> dp(size_t(1) << m, Mode::fromInt(0));
+	dp[0] = Mode::fromInt(1);
+	Value sum = Mode::fromInt(0);
+	for(size_t mask = 0; mask < dp.size(); ++mask){
+		if(Mode::isZero(dp[mask])){continue;}
+		size_t depth = static_cast<size_t>(__builtin_popcountll(mask));
+		if(depth == k){Mode::addTo(sum, dp[mask]); continue;}
+
+		Arrays::View arr = arrs[depth];
+		for(size_t i = 0; i < arr.size(); ++i){
+			if(mask >> i & 1){continue;}
+			Value term = dp[mask];
+			Mode::mulBy(term, Mode::fromInt(arr[i]));
+			Mode::addTo(dp[mask | size_t(1) << i], term);
+		}
+	}
+	return Mode::result(sum);
+}
+
+// When k == m the sum is the permanent of the k x k matrix of the arrays, missing elements
+// being zero. Ryser's formula
+//   perm(A) = (-1)^n * sum over column sets S of (-1)^|S| * prod_i sum_{j in S} a_ij
+// is evaluated over a Gray code, so each step updates the row sums by one column: O(k * 2^k).
+// Only valid when k == m.
+template <typename Mode = Wrapping64>
+typename Mode::Result sumRyser(const Arrays& arrs){
+	typedef typename Mode::Value Value;
+	size_t n = arrs.size();
+	if(n == 0){return Mode::result(Mode::fromInt(1));}
+
+	std::vector<Value> row_sums(n, Mode::fromInt(0));
+	Value total = Mode::fromInt(0);
+	for(uint64_t step = 1; step < uint64_t(1) << n; ++step){
+		size_t column = static_cast<size_t>(__builtin_ctzll(step));
+		uint64_t gray = step ^ (step >> 1);
+		bool added = gray >> column & 1;
+
+		Value prod = Mode::fromInt(1);
+		for(size_t i = 0; i < n; ++i){
+			Value value = Mode::fromInt(column < arrs[i].size() ? arrs[i][column] : 0);
+			if(added){
+				Mode::addTo(row_sums[i], value);
+			} else{
+				Mode::subFrom(row_sums[i], value);
+			}
+			Mode::mulBy(prod, row_sums[i]);
+		}
+		if(__builtin_popcountll(gray) % 2 == 0){
+			Mode::addTo(total, prod);
+		} else{
+			Mode::subFrom(total, prod);
+		}
+	}
+	if(n % 2 == 1){
+		Value negated = Mode::fromInt(0);
+		Mode::subFrom(negated, total);
+		total = negated;
+	}
+	return Mode::result(total);
+}
+
+// Number of nodes the DFS visits, bounded per level: array i has arrs[i].size() candidates,
+// of which at most m - i are still free. For k arrays of size m this is the sum of the
+// falling factorials m!/(m - d)!, d = 1 .. k.
+inline double dfsCost(const Arrays& arrs){
+	double m = indexRange(arrs);
+	double level = 1;
+	double total = 0;
+	for(size_t i = 0; i < arrs.size(); ++i){
+		level *= std::max(0.0, std::min(static_cast<double>(arrs[i].size()), m - static_cast<double>(i)));
+		total += level;
+	}
+	return total;
+}
+
+// The method with the fewest estimated steps: the DFS visits dfsCost nodes, spread over the
+// threads when there are enough of them; the subset DP scans m * 2^m transitions and is only
+// considered while its table fits in kMaxSubsetDpBytes; Ryser takes k * 2^k steps and is only
+// valid for k == m, and only used by modes whose intermediate sums cannot fail where the
+// final sum would not. Ties go to Ryser, then the DP.
+template <typename Mode = Wrapping64>
+Method chooseMethod(const Arrays& arrs, size_t threads = std::max(1u, std::thread::hardware_concurrency())){
+	int m = indexRange(arrs);
+	double dfs = dfsCost(arrs);
+	Method method = dfs < kMinParallelDfsCost ? Method::Dfs : Method::ParallelDfs;
+	double cost = method == Method::Dfs ? dfs : dfs / static_cast<double>(std::max<size_t>(1, threads));
+
+	double table = std::ldexp(1.0, m);
+	if(m <= kMaxSubsetDpIndices && table * sizeof(typename Mode::Value) <= static_cast<double>(kMaxSubsetDpBytes) && m * table <= cost){
+		method = Method::SubsetDp;
+		cost = m * table;
+	}
+	if(Mode::kRyserSafe && static_cast<int>(arrs.size()) == m && m <= kMaxRyserIndices && m * table <= cost){
+		method = Method::Ryser;
+	}
+	return method;
+}
+
+template <typename Mode = Wrapping64>
+typename Mode::Result sumInjectiveProducts(const Arrays& arrs, Method method){
+	switch(method){
+		case Method::Dfs: return sumDfs<Mode>(arrs);
+		case Method::ParallelDfs: return sumParallelDfs<Mode>(arrs);
+		case Method::SubsetDp: return sumSubsetDp<Mode>(arrs);
+		case Method::Ryser: return sumRyser<Mode>(arrs);
+	}
+	return Mode::result(Mode::fromInt(0));
+}
+
+template <typename Mode = Wrapping64>
+typename Mode::Result sumInjectiveProducts(const Arrays& arrs){
+	if(arrs.size() > static_cast<size_t>(indexRange(arrs))){return Mode::result(Mode::fromInt(0));}
+	return sumInjectiveProducts<Mode>(arrs, chooseMethod<Mode>(arrs));
+}
@@ -0,0 +1,380 @@
+#include "ingest.h"
+#include "solver.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <thread>
+
+std::vector<std::vector<int>> randomVectors(std::mt19937& rng, size_t k, int min_size, int max_size, int max_value){
+	std::uniform_int_distribution<int> size(min_size, max_size);
+	std::uniform_int_distribution<int> value(-max_value, max_value);
+	std::vector<std::vector<int>> arrs(k);
+	for(std::vector<int>& arr : arrs){
+		arr.resize(static_cast<size_t>(size(rng)));
+		for(int& x : arr){
+			x = value(rng);
+		}
+	}
+	return arrs;
+}
+
+Arrays randomArrays(std::mt19937& rng, size_t k, int min_size, int max_size, int max_value){
+	return Arrays(randomVectors(rng, k, min_size, max_size, max_value));
+}
+
+// ---------- Простые случаи ----------
+TEST(SolverTest, NoArrays) {
+	Arrays arrs;
+	EXPECT_EQ(sumDfs(arrs), 1);
+	EXPECT_EQ(sumSubsetDp(arrs), 1);
+	EXPECT_EQ(sumRyser(arrs), 1);
+	EXPECT_EQ(sumInjectiveProducts(arrs), 1);
+}
+
+TEST(SolverTest, SingleArrayIsItsSum) {
+	Arrays arrs = {{2, 3, 5}};
+	EXPECT_EQ(sumDfs(arrs), 10);
+	EXPECT_EQ(sumSubsetDp(arrs), 10);
+	EXPECT_EQ(sumInjectiveProducts(arrs), 10);
+}
+
+TEST(SolverTest, TwoArrays) {
+	// 1*4 + 1*5 + 2*3 + 2*5 = 25: index 1 of the second array may not repeat index 1.
+	Arrays arrs = {{1, 2}, {3, 4, 5}};
+	EXPECT_EQ(sumDfs(arrs), 1 * 4 + 1 * 5 + 2 * 3 + 2 * 5);
+	EXPECT_EQ(sumSubsetDp(arrs), 25);
+	EXPECT_EQ(sumInjectiveProducts(arrs), 25);
+}
+
+TEST(SolverTest, PermanentOfSquareMatrix) {
+	Arrays arrs = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+	EXPECT_EQ(sumRyser(arrs), 450);
+	EXPECT_EQ(sumDfs(arrs), 450);
+	EXPECT_EQ(sumSubsetDp(arrs), 450);
+}
+
+TEST(SolverTest, MoreArraysThanIndices) {
+	Arrays arrs = {{1, 2}, {3, 4}, {5, 6}};
+	EXPECT_EQ(sumDfs(arrs), 0);
+	EXPECT_EQ(sumSubsetDp(arrs), 0);
+	EXPECT_EQ(sumInjectiveProducts(arrs), 0);
+}
+
+TEST(SolverTest, ShortArraysPaddedForRyser) {
+	Arrays arrs = {{1}, {2, 3}, {4, 5, 6}};
+	EXPECT_EQ(sumDfs(arrs), 1 * 3 * 6);
+	EXPECT_EQ(sumRyser(arrs), 18);
+	EXPECT_EQ(sumSubsetDp(arrs), 18);
+}
+
+TEST(SolverTest, Twelve) {
+	Arrays arrs(12, std::vector<int>(12, 1));
+	// 12! injective choices, each of product 1.
+	EXPECT_EQ(sumInjectiveProducts(arrs), 479001600);
+	EXPECT_EQ(sumSubsetDp(arrs), 479001600);
+}
+
+// ---------- Выбор метода ----------
+TEST(ChooseMethodTest, CheapestByEstimatedCost) {
+	// Few arrays over a wide range: the DFS visits a handful of nodes, the DP would scan 2^24
+	// masks and allocate 128 MB.
+	EXPECT_EQ(chooseMethod(Arrays{std::vector<int>(24, 1)}, 8), Method::Dfs);
+	EXPECT_EQ(chooseMethod(Arrays(2, std::vector<int>(24, 1)), 8), Method::Dfs);
+	// Tiny squares are not worth a 2^k pass either.
+	EXPECT_EQ(chooseMethod(Arrays(3, std::vector<int>(3, 1)), 8), Method::Dfs);
+	EXPECT_EQ(chooseMethod(Arrays(10, std::vector<int>(10, 1)), 8), Method::Ryser);
+	EXPECT_EQ(chooseMethod(Arrays(10, std::vector<int>(12, 1)), 8), Method::SubsetDp);
+	// 12 of 20: 20!/8! DFS leaves against 20 * 2^20 DP steps.
+	EXPECT_EQ(chooseMethod(Arrays(12, std::vector<int>(20, 1)), 8), Method::SubsetDp);
+	EXPECT_EQ(chooseMethod(Arrays(4, std::vector<int>(40, 1)), 8), Method::ParallelDfs);
+	EXPECT_EQ(chooseMethod(Arrays(4, std::vector<int>(40, 1)), 1), Method::ParallelDfs);
+}
+
+TEST(ChooseMethodTest, DpTableStaysUnderTheMemoryCeiling) {
+	// 2^24 values are 128 MB in 64 bits and 256 MB in 128 bits, over kMaxSubsetDpBytes.
+	Arrays arrs(16, std::vector<int>(24, 1));
+	EXPECT_NE(chooseMethod<Wrapping64>(arrs, 8), Method::SubsetDp);
+	EXPECT_NE(chooseMethod<Int128>(arrs, 8), Method::SubsetDp);
+	Arrays smaller(14, std::vector<int>(22, 1));
+	EXPECT_EQ(chooseMethod<Wrapping64>(smaller, 8), Method::SubsetDp);
+	EXPECT_EQ(chooseMethod<Int128>(smaller, 8), Method::SubsetDp);
+	EXPECT_LE((size_t(1) << 22) * sizeof(Int128::Value), kMaxSubsetDpBytes);
+}
+
+// ---------- Перекрёстная проверка ----------
+TEST(SolverCrossCheckTest, RandomRagged) {
+	std::mt19937 rng(39);
+	for(int round = 0; round < 300; ++round){
+		Arrays arrs = randomArrays(rng, static_cast<size_t>(rng() % 6), 0, 7, 9);
+		long long expected = sumDfs(arrs);
+		EXPECT_EQ(sumSubsetDp(arrs), expected);
+		EXPECT_EQ(sumInjectiveProducts(arrs), expected);
+	}
+}
+
+TEST(SolverCrossCheckTest, RandomSquare) {
+	std::mt19937 rng(40);
+	for(int round = 0; round < 200; ++round){
+		size_t k = 1 + rng() % 7;
+		std::vector<std::vector<int>> vectors = randomVectors(rng, k, 0, static_cast<int>(k), 20);
+		vectors[rng() % k].resize(k, 1);
+		Arrays arrs(vectors);
+		long long expected = sumDfs(arrs);
+		EXPECT_EQ(sumRyser(arrs), expected);
+		EXPECT_EQ(sumSubsetDp(arrs), expected);
+		EXPECT_EQ(sumInjectiveProducts(arrs), expected);
+	}
+}
+
+TEST(SolverCrossCheckTest, LargeSquareDpAgainstRyser) {
+	std::mt19937 rng(41);
+	for(int round = 0; round < 5; ++round){
+		Arrays arrs = randomArrays(rng, 14, 14, 14, 3);
+		EXPECT_EQ(sumSubsetDp(arrs), sumRyser(arrs));
+	}
+}
+
+TEST(SolverCrossCheckTest, WrapsLikeDfs) {
+	// Products overflow 64 bits; all methods agree modulo 2^64.
+	std::mt19937 rng(42);
+	Arrays arrs = randomArrays(rng, 6, 6, 6, 1000000);
+	EXPECT_EQ(sumRyser(arrs), sumDfs(arrs));
+	EXPECT_EQ(sumSubsetDp(arrs), sumDfs(arrs));
+}
+
+TEST(SolverCrossCheckTest, ParallelDfs) {
+	std::mt19937 rng(43);
+	for(int round = 0; round < 100; ++round){
+		Arrays arrs = randomArrays(rng, static_cast<size_t>(rng() % 6), 0, 8, 9);
+		long long expected = sumDfs(arrs);
+		for(size_t split_depth : {size_t(0), size_t(1), size_t(2), size_t(3), size_t(10)}){
+			for(size_t threads : {size_t(1), size_t(3), size_t(8)}){
+				EXPECT_EQ(sumParallelDfs(arrs, split_depth, threads), expected);
+			}
+		}
+	}
+}
+
+TEST(SolverCrossCheckTest, ParallelDfsWideRange) {
+	// Index range past one bitset word, where only the DFS applies.
+	std::mt19937 rng(44);
+	Arrays arrs = randomArrays(rng, 3, 60, 90, 50);
+	EXPECT_EQ(chooseMethod(arrs), Method::ParallelDfs);
+	EXPECT_EQ(sumParallelDfs(arrs, 1, 4), sumDfs(arrs));
+	EXPECT_EQ(sumInjectiveProducts(arrs), sumDfs(arrs));
+}
+
+// ---------- Режимы накопления ----------
+TEST(AccumulationTest, ExactIntegerArithmetic) {
+	ExactInteger a(-1234567890123LL);
+	a *= ExactInteger(1000000007);
+	a *= ExactInteger(-998244353);
+	a += ExactInteger(-5);
+	EXPECT_EQ(a.toString(), Int128::toString(Int128::Result(-1234567890123LL) * 1000000007 * -998244353 - 5));
+	a -= a;
+	EXPECT_TRUE(a.isZero());
+	EXPECT_EQ(a.toString(), "0");
+	EXPECT_EQ(ExactInteger(-1000000000).toString(), "-1000000000");
+}
+
+TEST(AccumulationTest, CheckedDetectsOverflow) {
+	Arrays arrs(3, std::vector<int>(4, 1000000000));
+	EXPECT_THROW(sumDfs<Checked64>(arrs), std::overflow_error);
+	EXPECT_THROW(sumParallelDfs<Checked64>(arrs, 1, 3), std::overflow_error);
+	EXPECT_THROW(sumSubsetDp<Checked64>(arrs), std::overflow_error);
+
+	Arrays small = {{1, 2}, {3, 4, 5}};
+	EXPECT_EQ(sumInjectiveProducts<Checked64>(small), 25);
+}
+
+TEST(AccumulationTest, CheckedAvoidsRyser) {
+	// Over all three columns every row sums to 3 * 10^6, so Ryser's term 27 * 10^18 overflows
+	// although the answer, 3! * 10^18, fits.
+	Arrays arrs(3, std::vector<int>(3, 1000000));
+	Arrays square(12, std::vector<int>(12, 1));
+	EXPECT_EQ(chooseMethod<Wrapping64>(square), Method::Ryser);
+	EXPECT_NE(chooseMethod<Checked64>(square), Method::Ryser);
+	EXPECT_NE(chooseMethod<Checked64>(arrs), Method::Ryser);
+	EXPECT_THROW(sumRyser<Checked64>(arrs), std::overflow_error);
+	EXPECT_EQ(sumInjectiveProducts<Checked64>(arrs), 6000000000000000000LL);
+}
+
+TEST(AccumulationTest, WideModesAgree) {
+	std::mt19937 rng(45);
+	for(int round = 0; round < 20; ++round){
+		size_t k = 1 + rng() % 4;
+		Arrays arrs = randomArrays(rng, k, static_cast<int>(k), 6, 1000000000);
+		Int128::Result wide = sumDfs<Int128>(arrs);
+		EXPECT_EQ(sumSubsetDp<Int128>(arrs), wide);
+		EXPECT_EQ(sumParallelDfs<Int128>(arrs, 1, 2), wide);
+		EXPECT_EQ(sumDfs<Exact>(arrs).toString(), Int128::toString(wide));
+		EXPECT_EQ(sumSubsetDp<Exact>(arrs).toString(), Int128::toString(wide));
+
+		Int128::Result residue = wide % static_cast<Int128::Result>(ModPrime::kModulus);
+		if(residue < 0){residue += ModPrime::kModulus;}
+		EXPECT_EQ(sumDfs<ModPrime>(arrs), static_cast<uint64_t>(residue));
+		EXPECT_EQ(sumSubsetDp<ModPrime>(arrs), static_cast<uint64_t>(residue));
+	}
+}
+
+TEST(AccumulationTest, ExactAndModRyser) {
+	std::mt19937 rng(46);
+	for(int round = 0; round < 10; ++round){
+		Arrays arrs = randomArrays(rng, 6, 6, 6, 1000000000);
+		ExactInteger exact = sumDfs<Exact>(arrs);
+		EXPECT_EQ(sumRyser<Exact>(arrs), exact);
+		EXPECT_EQ(sumSubsetDp<Exact>(arrs), exact);
+		EXPECT_EQ(sumRyser<ModPrime>(arrs), sumDfs<ModPrime>(arrs));
+		EXPECT_EQ(sumRyser<Int128>(arrs), sumDfs<Int128>(arrs));
+	}
+}
+
+// ---------- Чтение входа ----------
+int parseOne(const std::string& text){
+	int value = 0;
+	const char* end = parseInt(text.data(), text.data() + text.size(), value);
+	EXPECT_EQ(end, text.data() + text.size());
+	return value;
+}
+
+TEST(IngestTest, ParsesIntegers) {
+	EXPECT_EQ(parseOne("0"), 0);
+	EXPECT_EQ(parseOne("7"), 7);
+	EXPECT_EQ(parseOne("-15"), -15);
+	EXPECT_EQ(parseOne("+42"), 42);
+	EXPECT_EQ(parseOne("12345678"), 12345678);
+	EXPECT_EQ(parseOne("123456789"), 123456789);
+	EXPECT_EQ(parseOne("2147483647"), 2147483647);
+	EXPECT_EQ(parseOne("-2147483648"), -2147483647 - 1);
+	EXPECT_EQ(parseOne("0000000000000000000042"), 42);
+	EXPECT_EQ(parseOne("-0"), 0);
+}
+
+TEST(IngestTest, RejectsMalformed) {
+	for(const char* text : {"", "-", "+", "12a", "1-2", "abc", "2147483648", "-2147483649", "99999999999", "12345678x9"}){
+		int value;
+		std::string s = text;
+		EXPECT_THROW(parseInt(s.data(), s.data() + s.size(), value), std::runtime_error) << text;
+	}
+}
+
+TEST(IngestTest, MatchesScalarOnRandomTokens) {
+	std::mt19937 rng(47);
+	std::uniform_int_distribution<int> value(INT_MIN, INT_MAX);
+	std::string text;
+	std::vector<int> expected;
+	for(int i = 0; i < 20000; ++i){
+		int x = rng() % 3 == 0 ? static_cast<int>(rng() % 1000) - 500 : value(rng);
+		expected.push_back(x);
+		text += std::to_string(x);
+		text += " \n\t"[rng() % 3];
+	}
+	const char* p = text.data();
+	const char* end = p + text.size();
+	for(int x : expected){
+		while(isSpace(*p)){++p;}
+		int parsed;
+		p = parseInt(p, end, parsed);
+		ASSERT_EQ(parsed, x);
+	}
+}
+
+TEST(IngestTest, ParseSize) {
+	EXPECT_EQ(parseSize("12"), 12);
+	EXPECT_EQ(parseSize("0"), 0);
+	EXPECT_THROW(parseSize(""), std::runtime_error);
+	EXPECT_THROW(parseSize("1x"), std::runtime_error);
+	EXPECT_THROW(parseSize("-3"), std::runtime_error);
+	EXPECT_THROW(parseSize("99999999999999999999999"), std::runtime_error);
+}
+
+Arrays readFromPipe(const std::string& text, const std::vector<size_t>& sizes){
+	int fds[2];
+	EXPECT_EQ(pipe(fds), 0);
+	std::thread writer([&]{
+		for(size_t i = 0; i < text.size(); i += 4093){
+			size_t n = std::min<size_t>(4093, text.size() - i);
+			EXPECT_EQ(write(fds[1], text.data() + i, n), static_cast<ssize_t>(n));
+		}
+		close(fds[1]);
+	});
+	try{
+		IntReader reader(fds[0]);
+		Arrays arrs = readArrays(reader, sizes);
+		writer.join();
+		close(fds[0]);
+		return arrs;
+	} catch(...){
+		char drain[4096];
+		while(read(fds[0], drain, sizeof(drain)) > 0){}
+		writer.join();
+		close(fds[0]);
+		throw;
+	}
+}
+
+TEST(IngestTest, ReadsArraysFromPipeAndFile) {
+	std::string text;
+	for(int i = 0; i < 300000; ++i){
+		text += std::to_string(i * 7919LL % 2000003 - 1000000) + (i % 10 == 9 ? "\n" : "  ");
+	}
+	std::vector<size_t> sizes = {100000, 0, 150000, 50000};
+	Arrays arrs = readFromPipe(text, sizes);
+	ASSERT_EQ(arrs.size(), 4);
+	EXPECT_EQ(arrs[1].size(), 0);
+	EXPECT_EQ(arrs[0][0], -1000000);
+	EXPECT_EQ(arrs[2][0], 100000LL * 7919 % 2000003 - 1000000);
+	EXPECT_EQ(arrs[3][49999], 299999LL * 7919 % 2000003 - 1000000);
+
+	char path[] = "/tmp/ingest_testXXXXXX";
+	int fd = mkstemp(path);
+	ASSERT_GE(fd, 0);
+	ASSERT_EQ(write(fd, text.data(), text.size()), static_cast<ssize_t>(text.size()));
+	lseek(fd, 0, SEEK_SET);
+	{
+		IntReader reader(fd);
+		Arrays mapped = readArrays(reader, sizes);
+		for(size_t i = 0; i < mapped.totalSize(); ++i){
+			ASSERT_EQ(mapped.data()[i], arrs.data()[i]);
+		}
+	}
+	close(fd);
+	unlink(path);
+}
+
+TEST(IngestTest, ReportsShortOrBadInput) {
+	EXPECT_THROW(readFromPipe("1 2 3", {2, 2}), std::runtime_error);
+	EXPECT_THROW(readFromPipe("1 2 x 4", {4}), std::runtime_error);
+	EXPECT_THROW(readFromPipe(std::string(5000, '0') + "1", {1}), std::runtime_error);
+}
+
+// The same tokens give the same result from a pipe, where the reader only keeps a window of
+// the input, and from a mapped file, where parseInt sees all of it.
+TEST(IngestTest, PipeAndFileAgreeOnLongTokens) {
+	auto outcome = [](auto read){
+		try{
+			return std::to_string(read()[0][0]);
+		} catch(const std::runtime_error& error){
+			return std::string(error.what());
+		}
+	};
+	char path[] = "/tmp/ingest_testXXXXXX";
+	int fd = mkstemp(path);
+	ASSERT_GE(fd, 0);
+	for(size_t length = kMaxIntegerLength - 2; length <= kMaxIntegerLength + 2; ++length){
+		for(const std::string& tail : {std::string("7"), std::string("7x"), std::string("-7")}){
+			std::string token = std::string(length - std::min(length, tail.size()), '0') + tail;
+			std::string text = token + (length % 2 == 0 ? " 5" : "");
+			ASSERT_EQ(ftruncate(fd, 0), 0);
+			ASSERT_EQ(pwrite(fd, text.data(), text.size(), 0), static_cast<ssize_t>(text.size()));
+			std::string fromFile = outcome([&]{
+				lseek(fd, 0, SEEK_SET);
+				IntReader reader(fd);
+				return readArrays(reader, {1});
+			});
+			EXPECT_EQ(outcome([&]{ return readFromPipe(text, {1}); }), fromFile) << token;
+			EXPECT_EQ(fromFile == "integer too long", token.size() >= kMaxIntegerLength) << token;
+		}
+	}
+	close(fd);
+	unlink(path);
+}
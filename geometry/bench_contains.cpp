@@ -0,0 +1,73 @@
+#include "geometry.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Usage: bench_contains [vertices [points]]
+// Classifies random points against a random star-shaped polygon (10^4 vertices and 10^5 points
+// by default), in double and in float, with the scalar containsPoint loop and with
+// containsPoints on 1, 2, 4, ... threads up to one per core, and prints points per second and
+// per second per core. Without AVX only float is vectorized (see kVectorizeContains). Build with
+//   g++ -std=c++20 -O2 -march=native bench_contains.cpp instantiations.cpp -lpthread
+
+template <typename Func>
+static double seconds(Func func){
+    auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char* name, const char* type, size_t threads, size_t points, double time, size_t inside){
+    double rate = static_cast<double>(points) / time;
+    std::printf("%-14s %-6s %3zu threads  %8.3f s  %10.3g points/s  %10.3g points/s per core  (%zu inside)\n",
+        name, type, threads, time, rate, rate / static_cast<double>(threads), inside);
+}
+
+template <typename T>
+static bool run(const char* type, size_t n, size_t count){
+    using Vertex = BasicPoint<T>;
+    std::mt19937_64 rng(1);
+    std::uniform_real_distribution<double> radius(0.5, 1.0);
+    std::uniform_real_distribution<double> coordinate(-1.0, 1.0);
+    std::vector<Vertex> vertices;
+    for(size_t i = 0; i < n; ++i){
+        double angle = 2 * M_PI * static_cast<double>(i) / static_cast<double>(n);
+        double r = radius(rng);
+        vertices.emplace_back(static_cast<T>(r * std::cos(angle)), static_cast<T>(r * std::sin(angle)));
+    }
+    const BasicPolygon<T> polygon(vertices);
+    std::vector<Vertex> points(count);
+    for(Vertex& point : points) point = Vertex(static_cast<T>(coordinate(rng)), static_cast<T>(coordinate(rng)));
+
+    std::vector<uint8_t> expected(count);
+    double time = seconds([&](){
+        for(size_t i = 0; i < count; ++i) expected[i] = polygon.containsPoint(points[i]);
+    });
+    size_t inside = 0;
+    for(uint8_t value : expected) inside += value;
+    report("containsPoint", type, 1, count, time, inside);
+
+    std::vector<uint8_t> out(count);
+    for(size_t threads = 1; ; threads = std::min(2 * threads, hardwareThreads())){
+        time = seconds([&](){ polygon.containsPoints(points, out, threads); });
+        if(out != expected){
+            std::fprintf(stderr, "containsPoints differs from containsPoint\n");
+            return false;
+        }
+        report("containsPoints", type, threads, count, time, inside);
+        if(threads == hardwareThreads()) break;
+    }
+    return true;
+}
+
+int main(int argc, char** argv){
+    size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+    size_t count = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+    if(n < 3){
+        std::fprintf(stderr, "a polygon needs at least 3 vertices\n");
+        return 1;
+    }
+    return run<double>("double", n, count) && run<float>("float", n, count) ? 0 : 1;
+}
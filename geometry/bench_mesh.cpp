@@ -0,0 +1,100 @@
+#include "mesh.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Usage: bench_mesh [triangles]
+// Builds a jittered grid mesh (10^6 triangles by default) and times every metric of every
+// triangle computed through BasicTriangle objects, as callers did before analyzeMesh, against
+// analyzeMesh on 1, 2, 4, ... threads up to one per core, in double and in float. Prints
+// triangles per second and per second per core. Build with
+//   g++ -std=c++20 -O2 -march=native bench_mesh.cpp instantiations.cpp -lpthread
+
+template <typename Func>
+static double best(Func func){
+    double result = 0;
+    for(int run = 0; run < 3; ++run){
+        auto start = std::chrono::steady_clock::now();
+        func();
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result = run == 0 ? time : std::min(result, time);
+    }
+    return result;
+}
+
+// Sum of the area and inradius of every triangle, the metrics both paths compute the same way;
+// it only shows that the work was done and that the two agree.
+template <typename T>
+static double checksum(const BasicMeshMetrics<T>& metrics){
+    double sum = 0;
+    for(size_t i = 0; i < metrics.area.size(); ++i) sum += static_cast<double>(metrics.area[i] + metrics.inradius[i]);
+    return sum;
+}
+
+static void report(const char* name, const char* type, size_t threads, size_t triangles, double time, double checksum){
+    double rate = static_cast<double>(triangles) / time;
+    std::printf("%-12s %-6s %3zu threads  %8.3f s  %10.3g triangles/s  %10.3g triangles/s per core  (checksum %.6g)\n",
+        name, type, threads, time, rate, rate / static_cast<double>(threads), checksum);
+}
+
+template <typename T>
+static void run(const char* type, size_t size){
+    // A jittered grid, 1000 cells wide, two triangles per cell.
+    const size_t kWidth = 1000;
+    size_t rows = (size + 2 * kWidth - 1) / (2 * kWidth);
+    std::mt19937_64 rng(1);
+    std::uniform_real_distribution<double> jitter(-0.2, 0.2);
+    BasicTriangleMesh<T> mesh;
+    for(size_t row = 0; row <= rows; ++row){
+        for(size_t column = 0; column <= kWidth; ++column){
+            mesh.vertices.emplace_back(static_cast<T>(static_cast<double>(column) + jitter(rng)), static_cast<T>(static_cast<double>(row) + jitter(rng)));
+        }
+    }
+    for(size_t i = 0; i < size; ++i){
+        size_t cell = i / 2;
+        uint32_t corner = static_cast<uint32_t>(cell / kWidth * (kWidth + 1) + cell % kWidth);
+        uint32_t above = corner + static_cast<uint32_t>(kWidth + 1);
+        if(i % 2 == 0){
+            mesh.triangles.push_back({corner, corner + 1, above + 1});
+        } else{
+            mesh.triangles.push_back({corner, above + 1, above});
+        }
+    }
+
+    // Both paths fill the same BasicMeshMetrics, so they do the same stores; each time is the
+    // best of three runs.
+    BasicMeshMetrics<T> reference;
+    reference.resize(size);
+    double time = best([&](){
+        for(size_t i = 0; i < size; ++i){
+            BasicTriangle<T> triangle = mesh.triangle(i);
+            BasicCircle<T> circumscribed = triangle.circumscribedCircle();
+            BasicCircle<T> inscribed = triangle.inscribedCircle();
+            reference.area[i] = triangle.area();
+            reference.circumradius[i] = circumscribed.radius();
+            reference.inradius[i] = inscribed.radius();
+            reference.quality[i] = 2 * inscribed.radius() / circumscribed.radius();
+            reference.circumcenter[i] = circumscribed.center();
+            reference.incenter[i] = inscribed.center();
+            reference.centroid[i] = triangle.centroid();
+            reference.orthocenter[i] = triangle.orthocenter();
+        }
+    });
+    report("Triangle", type, 1, size, time, checksum(reference));
+
+    BasicMeshMetrics<T> metrics;
+    for(size_t threads = 1; ; threads = std::min(2 * threads, hardwareThreads())){
+        time = best([&](){ analyzeMesh(mesh, metrics, threads); });
+        report("analyzeMesh", type, threads, size, time, checksum(metrics));
+        if(threads == hardwareThreads()) break;
+    }
+}
+
+int main(int argc, char** argv){
+    size_t size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    run<double>("double", size);
+    run<float>("float", size);
+    return 0;
+}
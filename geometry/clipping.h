@@ -0,0 +1,379 @@
+#pragma once
+#include "geometry.h"
+#include "parallel.h"
+
+// Polygon combination engine: convex hull, convex intersection and Minkowski sum in linear
+// time after sorting, Sutherland-Hodgman clipping by a convex window and Weiler-Atherton
+// (Greiner-Hormann variant) boolean operations for general simple polygons.
+// Results are counter-clockwise unless stated otherwise.
+
+static constexpr size_t kParallelHullThreshold = 1'000'000;
+
+inline double orientation(const Point& a, const Point& b, const Point& c){
+    return (b - a).crossProduct(c - a);
+}
+
+inline double signedArea(const std::vector<Point>& v){
+    double result = 0;
+    for(size_t i = 0, n = v.size(); i < n; ++i) result += v[i].crossProduct(v[(i + 1) % n]);
+    return result / 2;
+}
+
+inline std::vector<Point> counterClockwise(std::vector<Point> v){
+    if(signedArea(v) < 0) std::reverse(v.begin(), v.end());
+    return v;
+}
+
+// Drops consecutive duplicates (including the wrap-around pair) left by the clipping loops.
+inline std::vector<Point> removeDuplicates(const std::vector<Point>& v){
+    std::vector<Point> result;
+    for(const Point& p : v){
+        if(result.empty() || result.back() != p) result.push_back(p);
+    }
+    while(result.size() > 1 && result.front() == result.back()) result.pop_back();
+    return result;
+}
+
+// Andrew's monotone chain on an already sorted range; collinear points are dropped. Turns are
+// decided by the exact predicate, so nearly collinear input cannot produce a reflex vertex.
+inline std::vector<Point> monotoneChain(const std::vector<Point>& sorted){
+    size_t n = sorted.size();
+    if(n < 3) return sorted;
+    std::vector<Point> hull(2 * n);
+    size_t k = 0;
+    for(size_t i = 0; i < n; ++i){
+        while(k >= 2 && orientationSign(hull[k - 2], hull[k - 1], sorted[i]) <= 0) --k;
+        hull[k++] = sorted[i];
+    }
+    for(size_t i = n - 1, lower = k + 1; i > 0; --i){
+        while(k >= lower && orientationSign(hull[k - 2], hull[k - 1], sorted[i - 1]) <= 0) --k;
+        hull[k++] = sorted[i - 1];
+    }
+    hull.resize(k - 1);
+    return hull;
+}
+
+inline bool lexicographicLess(const Point& a, const Point& b){
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+inline std::vector<Point> sequentialConvexHull(std::vector<Point> points){
+    std::sort(points.begin(), points.end(), lexicographicLess);
+    return monotoneChain(points);
+}
+
+// Every core builds the hull of its own slice; the union of those hulls is tiny compared
+// to the input, so the final merge is a cheap sequential pass.
+inline std::vector<Point> parallelConvexHull(const std::vector<Point>& points){
+    size_t chunks = std::max(1u, std::thread::hardware_concurrency());
+    if(chunks == 1) return sequentialConvexHull(points);
+    size_t chunkSize = (points.size() + chunks - 1) / chunks;
+    std::vector<std::vector<Point>> partial(chunks);
+    parallelFor(chunks, 1, [&](size_t begin, size_t end){
+        for(size_t c = begin; c < end; ++c){
+            size_t from = std::min(points.size(), c * chunkSize);
+            size_t to = std::min(points.size(), from + chunkSize);
+            partial[c] = sequentialConvexHull(std::vector<Point>(points.begin() + static_cast<std::ptrdiff_t>(from),
+                                                                 points.begin() + static_cast<std::ptrdiff_t>(to)));
+        }
+    });
+
+    std::vector<Point> candidates;
+    for(const std::vector<Point>& hull : partial) candidates.insert(candidates.end(), hull.begin(), hull.end());
+    return sequentialConvexHull(std::move(candidates));
+}
+
+inline Polygon convexHull(const std::vector<Point>& points){
+    if(points.size() > kParallelHullThreshold) return Polygon(parallelConvexHull(points));
+    return Polygon(sequentialConvexHull(points));
+}
+
+// Minkowski sum of two convex polygons by merging their edge sequences by polar angle.
+inline Polygon minkowskiSum(const Polygon& first, const Polygon& second){
+    std::vector<Point> a = counterClockwise(first.getVertices());
+    std::vector<Point> b = counterClockwise(second.getVertices());
+    auto lowest = [](const std::vector<Point>& v){
+        return static_cast<size_t>(std::min_element(v.begin(), v.end(), [](const Point& p, const Point& q){
+            return p.y < q.y || (p.y == q.y && p.x < q.x);
+        }) - v.begin());
+    };
+    std::rotate(a.begin(), a.begin() + static_cast<std::ptrdiff_t>(lowest(a)), a.end());
+    std::rotate(b.begin(), b.begin() + static_cast<std::ptrdiff_t>(lowest(b)), b.end());
+
+    size_t n = a.size();
+    size_t m = b.size();
+    std::vector<Point> result;
+    result.reserve(n + m);
+    size_t i = 0;
+    size_t j = 0;
+    while(i < n || j < m){
+        result.push_back(a[i % n] + b[j % m]);
+        double cross = (a[(i + 1) % n] - a[i % n]).crossProduct(b[(j + 1) % m] - b[j % m]);
+        if(j == m || (i < n && cross > kAccuracy)) ++i;
+        else if(i == n || cross < -kAccuracy) ++j;
+        else{
+            ++i;
+            ++j;
+        }
+    }
+    return Polygon(removeDuplicates(result));
+}
+
+// Clips an arbitrary polygon by a convex window.
+inline Polygon sutherlandHodgman(const Polygon& subject, const Polygon& window){
+    std::vector<Point> output = subject.getVertices();
+    std::vector<Point> clip = counterClockwise(window.getVertices());
+    for(size_t e = 0, m = clip.size(); e < m && !output.empty(); ++e){
+        const Point& a = clip[e];
+        const Point& b = clip[(e + 1) % m];
+        std::vector<Point> input;
+        input.swap(output);
+        for(size_t i = 0, n = input.size(); i < n; ++i){
+            const Point& current = input[i];
+            const Point& previous = input[(i + n - 1) % n];
+            bool currentInside = orientation(a, b, current) >= -kAccuracy;
+            bool previousInside = orientation(a, b, previous) >= -kAccuracy;
+            if(currentInside != previousInside){
+                output.push_back(Line(a, b).intersection(Line(previous, current)));
+            }
+            if(currentInside) output.push_back(current);
+        }
+    }
+    return Polygon(removeDuplicates(output));
+}
+
+// O(n + m) intersection of two convex polygons (O'Rourke, Chien, Olson and Naddor).
+inline Polygon convexIntersection(const Polygon& first, const Polygon& second){
+    std::vector<Point> p = counterClockwise(first.getVertices());
+    std::vector<Point> q = counterClockwise(second.getVertices());
+    size_t n = p.size();
+    size_t m = q.size();
+
+    enum class Inside{ Unknown, P, Q };
+    auto sign = [](double value){ return value > kAccuracy ? 1 : (value < -kAccuracy ? -1 : 0); };
+
+    std::vector<Point> result;
+    Inside inside = Inside::Unknown;
+    size_t a = 0;
+    size_t b = 0;
+    size_t aSteps = 0;
+    size_t bSteps = 0;
+
+    auto advance = [&](size_t& index, size_t& steps, size_t count, bool emit, const Point& vertex){
+        if(emit) result.push_back(vertex);
+        ++steps;
+        index = (index + 1) % count;
+    };
+
+    do{
+        size_t a1 = (a + n - 1) % n;
+        size_t b1 = (b + m - 1) % m;
+        Point edgeA = p[a] - p[a1];
+        Point edgeB = q[b] - q[b1];
+
+        int cross = sign(edgeA.crossProduct(edgeB));
+        int aHB = sign(orientation(q[b1], q[b], p[a]));
+        int bHA = sign(orientation(p[a1], p[a], q[b]));
+
+        double denominator = edgeA.crossProduct(edgeB);
+        if(std::fabs(denominator) > kAccuracy){
+            double s = (q[b1] - p[a1]).crossProduct(edgeB) / denominator;
+            double t = (q[b1] - p[a1]).crossProduct(edgeA) / denominator;
+            if(s >= -kAccuracy && s <= 1 + kAccuracy && t >= -kAccuracy && t <= 1 + kAccuracy){
+                if(inside == Inside::Unknown) aSteps = bSteps = 0;
+                result.push_back(p[a1] + edgeA * s);
+                if(aHB > 0) inside = Inside::P;
+                else if(bHA > 0) inside = Inside::Q;
+            }
+        }
+
+        if(cross == 0 && aHB < 0 && bHA < 0) return Polygon(std::vector<Point>());
+
+        if(cross == 0 && aHB == 0 && bHA == 0){
+            if(inside == Inside::P) advance(b, bSteps, m, false, q[b]);
+            else advance(a, aSteps, n, false, p[a]);
+        } else if(cross >= 0){
+            if(bHA > 0) advance(a, aSteps, n, inside == Inside::P, p[a]);
+            else advance(b, bSteps, m, inside == Inside::Q, q[b]);
+        } else{
+            if(aHB > 0) advance(b, bSteps, m, inside == Inside::Q, q[b]);
+            else advance(a, aSteps, n, inside == Inside::P, p[a]);
+        }
+    } while((aSteps < n || bSteps < m) && aSteps < 2 * n && bSteps < 2 * m);
+
+    if(inside == Inside::Unknown){
+        Polygon pp(p);
+        Polygon qq(q);
+        if(qq.containsPoint(p[0])) return pp;
+        if(pp.containsPoint(q[0])) return qq;
+        return Polygon(std::vector<Point>());
+    }
+    return Polygon(removeDuplicates(result));
+}
+
+enum class ClipOperation{
+    Intersection,
+    Union,
+    Difference
+};
+
+// Weiler-Atherton style boolean operation on simple polygons, in the Greiner-Hormann form:
+// both outlines are threaded with their crossing points and the result is traced by
+// switching outlines at every crossing. Input is assumed to be in general position
+// (no vertex lying exactly on the other outline). When the outlines do not cross the
+// result is decided by containment; a clockwise polygon in the result is a hole of the
+// preceding one.
+inline std::vector<Polygon> clip(const Polygon& subject, const Polygon& window, ClipOperation operation){
+    struct Node{
+        Point point;
+        size_t next = 0;
+        size_t prev = 0;
+        size_t neighbor = 0;
+        bool intersection = false;
+        bool entry = false;
+        bool visited = false;
+    };
+
+    struct Crossing{
+        size_t edgeS;
+        size_t edgeC;
+        double alphaS;
+        double alphaC;
+        Point point;
+        size_t nodeS = 0;
+        size_t nodeC = 0;
+    };
+
+    std::vector<Point> s = counterClockwise(subject.getVertices());
+    std::vector<Point> c = counterClockwise(window.getVertices());
+    size_t n = s.size();
+    size_t m = c.size();
+
+    std::vector<Crossing> crossings;
+    for(size_t i = 0; i < n; ++i){
+        Point ds = s[(i + 1) % n] - s[i];
+        for(size_t j = 0; j < m; ++j){
+            Point dc = c[(j + 1) % m] - c[j];
+            double denominator = ds.crossProduct(dc);
+            if(std::fabs(denominator) < kAccuracy) continue;
+            double alphaS = (c[j] - s[i]).crossProduct(dc) / denominator;
+            double alphaC = (c[j] - s[i]).crossProduct(ds) / denominator;
+            if(alphaS > 0 && alphaS < 1 && alphaC > 0 && alphaC < 1){
+                crossings.push_back({i, j, alphaS, alphaC, s[i] + ds * alphaS});
+            }
+        }
+    }
+
+    Polygon subjectPolygon(s);
+    Polygon windowPolygon(c);
+
+    if(crossings.empty()){
+        bool subjectInside = windowPolygon.containsPoint(s[0]);
+        bool windowInside = subjectPolygon.containsPoint(c[0]);
+        std::vector<Point> hole(c.rbegin(), c.rend());
+        switch(operation){
+            case ClipOperation::Intersection:
+                if(subjectInside) return {subjectPolygon};
+                if(windowInside) return {windowPolygon};
+                return {};
+            case ClipOperation::Union:
+                if(subjectInside) return {windowPolygon};
+                if(windowInside) return {subjectPolygon};
+                return {subjectPolygon, windowPolygon};
+            case ClipOperation::Difference:
+                if(subjectInside) return {};
+                if(windowInside) return {subjectPolygon, Polygon(hole)};
+                return {subjectPolygon};
+        }
+    }
+
+    std::vector<Node> nodes;
+    nodes.reserve(n + m + 2 * crossings.size());
+    auto thread = [&](const std::vector<Point>& outline, bool isSubject){
+        size_t first = nodes.size();
+        for(size_t i = 0; i < outline.size(); ++i){
+            nodes.push_back({outline[i]});
+            std::vector<size_t> onEdge;
+            for(size_t k = 0; k < crossings.size(); ++k){
+                if((isSubject ? crossings[k].edgeS : crossings[k].edgeC) == i) onEdge.push_back(k);
+            }
+            std::sort(onEdge.begin(), onEdge.end(), [&](size_t x, size_t y){
+                return isSubject ? crossings[x].alphaS < crossings[y].alphaS : crossings[x].alphaC < crossings[y].alphaC;
+            });
+            for(size_t k : onEdge){
+                (isSubject ? crossings[k].nodeS : crossings[k].nodeC) = nodes.size();
+                Node node{crossings[k].point};
+                node.intersection = true;
+                nodes.push_back(node);
+            }
+        }
+        size_t last = nodes.size();
+        for(size_t i = first; i < last; ++i){
+            nodes[i].next = i + 1 == last ? first : i + 1;
+            nodes[i].prev = i == first ? last - 1 : i - 1;
+        }
+        return first;
+    };
+    size_t startS = thread(s, true);
+    size_t startC = thread(c, false);
+    for(const Crossing& crossing : crossings){
+        nodes[crossing.nodeS].neighbor = crossing.nodeC;
+        nodes[crossing.nodeC].neighbor = crossing.nodeS;
+    }
+
+    // Entry flags alternate along each outline; the operation decides the starting parity.
+    auto markEntries = [&](size_t start, bool entering){
+        size_t i = start;
+        do{
+            if(nodes[i].intersection){
+                nodes[i].entry = entering;
+                entering = !entering;
+            }
+            i = nodes[i].next;
+        } while(i != start);
+    };
+    bool subjectStartsOutside = !windowPolygon.containsPoint(s[0]);
+    bool windowStartsOutside = !subjectPolygon.containsPoint(c[0]);
+    markEntries(startS, operation == ClipOperation::Intersection ? subjectStartsOutside : !subjectStartsOutside);
+    markEntries(startC, operation == ClipOperation::Union ? !windowStartsOutside : windowStartsOutside);
+
+    std::vector<std::vector<Point>> loops;
+    for(const Crossing& crossing : crossings){
+        size_t current = crossing.nodeS;
+        if(nodes[current].visited) continue;
+        std::vector<Point> outline{nodes[current].point};
+        do{
+            nodes[current].visited = true;
+            nodes[nodes[current].neighbor].visited = true;
+            bool forward = nodes[current].entry;
+            do{
+                current = forward ? nodes[current].next : nodes[current].prev;
+                outline.push_back(nodes[current].point);
+            } while(!nodes[current].intersection);
+            current = nodes[current].neighbor;
+        } while(!nodes[current].visited);
+        std::vector<Point> cleaned = removeDuplicates(outline);
+        if(cleaned.size() >= 3) loops.push_back(counterClockwise(cleaned));
+    }
+
+    // A traced loop inside an odd number of others is a hole (a union of two polygons can
+    // enclose one). Each hole goes right after the smallest outer loop around it, clockwise.
+    size_t count = loops.size();
+    std::vector<std::vector<size_t>> containers(count);
+    for(size_t i = 0; i < count; ++i){
+        for(size_t j = 0; j < count; ++j){
+            if(i != j && Polygon(loops[j]).containsPoint(loops[i][0])) containers[i].push_back(j);
+        }
+    }
+    std::vector<Polygon> result;
+    for(size_t outer = 0; outer < count; ++outer){
+        if(containers[outer].size() % 2 == 1) continue;
+        result.emplace_back(loops[outer]);
+        for(size_t hole = 0; hole < count; ++hole){
+            if(containers[hole].size() != containers[outer].size() + 1) continue;
+            bool inside = std::find(containers[hole].begin(), containers[hole].end(), outer) != containers[hole].end();
+            if(inside) result.emplace_back(std::vector<Point>(loops[hole].rbegin(), loops[hole].rend()));
+        }
+    }
+    return result;
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include "geometry.h"
+#include "parallel.h"
+#include <map>
+#include <numeric>
+#include <unordered_map>
+
+// Representatives of one signature partition, indexed by their measures so that every one a
+// shape may match is found without trying the others. All measures but the last pick a bucket
+// (see ShapeSignature::bucketWidth), and a shape looks in the at most two buckets per dimension
+// within its tolerance. In a bucket representatives are ordered by the last measure, which is
+// searched by range; with a relative tolerance they are also split by the binary exponent of
+// their scale, and each band is searched with the range its largest scale allows, or in full
+// when the bound does not apply. Representatives without bounds (or measures) are offered to
+// every shape, and shapes without them are offered every representative.
+class SignatureIndex{
+public:
+    void insert(const ShapeSignature& signature, size_t group){
+        ++count_;
+        if(!signature.bounded || signature.measures.empty()){
+            everywhere_.push_back(group);
+            return;
+        }
+        int band = signature.relative ? std::ilogb(signature.scale) : 0;
+        if(std::find(bands_.begin(), bands_.end(), band) == bands_.end()) bands_.push_back(band);
+        size_t dimensions = signature.measures.size() - 1;
+        std::vector<int64_t> bucket(dimensions);
+        for(size_t i = 0; i < dimensions; ++i){
+            bucket[i] = ShapeSignature::quantize(signature.measures[i], signature.bucketWidth(i));
+        }
+        buckets_[key(bucket, band)].emplace(signature.measures.back(), group);
+    }
+
+    // Appends the groups `signature` may match, in no particular order.
+    void candidates(const ShapeSignature& signature, std::vector<size_t>& out) const{
+        if(!signature.bounded || signature.measures.empty()){
+            for(size_t group = 0; group < count_; ++group) out.push_back(group);
+            return;
+        }
+        out.insert(out.end(), everywhere_.begin(), everywhere_.end());
+        size_t dimensions = signature.measures.size() - 1;
+        std::vector<int64_t> low(dimensions);
+        std::vector<int64_t> high(dimensions);
+        for(size_t i = 0; i < dimensions; ++i){
+            double value = signature.measures[i];
+            double tolerance = signature.tolerances[i];
+            low[i] = ShapeSignature::quantize(value - tolerance, signature.bucketWidth(i));
+            high[i] = ShapeSignature::quantize(value + tolerance, signature.bucketWidth(i));
+        }
+        double value = signature.measures.back();
+        double tolerance = signature.tolerances.back();
+        std::vector<int64_t> bucket;
+        for(int band : bands_){
+            double range = tolerance;
+            bool whole = false;
+            if(signature.relative){
+                double largest = std::ldexp(1.0, band + 1);
+                if(signature.scale >= tolerance * largest) range = tolerance * (largest / signature.scale + 1);
+                else whole = true;
+            }
+            // Counts through the buckets between low and high, the first dimension fastest.
+            bucket = low;
+            while(true){
+                auto found = buckets_.find(key(bucket, band));
+                if(found != buckets_.end()){
+                    auto it = whole ? found->second.begin() : found->second.lower_bound(value - range);
+                    for(; it != found->second.end() && (whole || it->first <= value + range); ++it) out.push_back(it->second);
+                }
+                size_t i = 0;
+                while(i < dimensions && bucket[i] == high[i]){
+                    bucket[i] = low[i];
+                    ++i;
+                }
+                if(i == dimensions) break;
+                ++bucket[i];
+            }
+        }
+    }
+
+private:
+    // A collision merely merges two buckets, whose representatives are then offered together.
+    static uint64_t key(const std::vector<int64_t>& bucket, int band){
+        uint64_t h = ShapeSignature::mix(0, band);
+        for(int64_t value : bucket) h = ShapeSignature::mix(h, value);
+        return h;
+    }
+
+    size_t count_ = 0;
+    std::vector<size_t> everywhere_;
+    std::vector<int> bands_;
+    std::unordered_map<uint64_t, std::multimap<double, size_t>> buckets_;
+};
+
+// Bulk grouping of shapes into congruence (or similarity) classes. Signatures are computed in
+// parallel and shapes are partitioned by signature key. A shape joins the first group, by
+// smallest index, whose representative (its first shape) it matches, and only representatives
+// a SignatureIndex offers are tried. Since it offers every one the shape could match, the
+// result is exactly what comparing against every earlier representative would give.
+// Partitions are scanned in index order, the small ones each on a core of its own. Large ones
+// use all `threads` a block at a time: the block's shapes are tried against the earlier
+// representatives in parallel, and only the ones left over then go, in order, through the
+// representatives the block itself adds.
+// Groups hold indices into `shapes` and are ordered by their smallest index.
+inline std::vector<std::vector<size_t>> groupShapes(const std::vector<const Shape*>& shapes, bool similar,
+        size_t threads = hardwareThreads()){
+    static constexpr size_t kParallelPartition = 4096;
+    size_t n = shapes.size();
+    std::vector<ShapeSignature> signatures(n);
+    parallelFor(n, 1024, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; ++i) signatures[i] = shapes[i]->signature(similar);
+    }, threads);
+
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b){
+        if(signatures[a].hash != signatures[b].hash) return signatures[a].hash < signatures[b].hash;
+        if(signatures[a].key != signatures[b].key) return signatures[a].key < signatures[b].key;
+        return a < b;
+    });
+
+    std::vector<size_t> partitionStarts;
+    for(size_t i = 0; i < n; ++i){
+        if(i == 0 || !signatures[order[i]].sameKey(signatures[order[i - 1]])) partitionStarts.push_back(i);
+    }
+    partitionStarts.push_back(n);
+
+    std::vector<std::vector<std::vector<size_t>>> partitionGroups(partitionStarts.size() - 1);
+    auto scan = [&](size_t p, size_t workers){
+        std::vector<std::vector<size_t>>& groups = partitionGroups[p];
+        SignatureIndex index;
+        // The first group, from `first` on, whose representative shape i matches, or SIZE_MAX.
+        auto place = [&](size_t i, size_t first, std::vector<size_t>& candidates){
+            candidates.clear();
+            index.candidates(signatures[i], candidates);
+            // Groups are numbered in creation order, which is the order of their first index.
+            std::sort(candidates.begin(), candidates.end());
+            for(size_t g : candidates){
+                if(g < first) continue;
+                const Shape& representative = *shapes[groups[g].front()];
+                if(similar ? shapes[i]->isSimilarTo(representative) : shapes[i]->isCongruentTo(representative)) return g;
+            }
+            return SIZE_MAX;
+        };
+
+        size_t begin = partitionStarts[p];
+        size_t end = partitionStarts[p + 1];
+        size_t block = workers == 1 ? end - begin : kParallelPartition;
+        std::vector<size_t> candidates;
+        std::vector<size_t> placed;
+        for(size_t first = begin; first < end; first += block){
+            size_t last = std::min(end, first + block);
+            size_t known = groups.size();
+            placed.assign(last - first, SIZE_MAX);
+            if(known > 0){
+                parallelFor(last - first, 64, [&](size_t from, size_t to){
+                    std::vector<size_t> local;
+                    for(size_t j = from; j < to; ++j) placed[j] = place(order[first + j], 0, local);
+                }, workers);
+            }
+            for(size_t j = 0; j < last - first; ++j){
+                size_t i = order[first + j];
+                size_t g = placed[j] != SIZE_MAX ? placed[j] : place(i, known, candidates);
+                if(g != SIZE_MAX){
+                    groups[g].push_back(i);
+                } else{
+                    index.insert(signatures[i], groups.size());
+                    groups.push_back({i});
+                }
+            }
+        }
+    };
+    auto large = [&](size_t p){
+        return partitionStarts[p + 1] - partitionStarts[p] >= kParallelPartition;
+    };
+    parallelFor(partitionGroups.size(), 64, [&](size_t begin, size_t end){
+        for(size_t p = begin; p < end; ++p){
+            if(!large(p)) scan(p, 1);
+        }
+    }, threads);
+    for(size_t p = 0; p < partitionGroups.size(); ++p){
+        if(large(p)) scan(p, threads);
+    }
+
+    std::vector<std::vector<size_t>> result;
+    for(std::vector<std::vector<size_t>>& groups : partitionGroups){
+        for(std::vector<size_t>& group : groups) result.push_back(std::move(group));
+    }
+    std::sort(result.begin(), result.end(), [](const std::vector<size_t>& a, const std::vector<size_t>& b){
+        return a.front() < b.front();
+    });
+    return result;
+}
+
+inline std::vector<std::vector<size_t>> groupCongruent(const std::vector<const Shape*>& shapes){
+    return groupShapes(shapes, false);
+}
+
+inline std::vector<std::vector<size_t>> groupSimilar(const std::vector<const Shape*>& shapes){
+    return groupShapes(shapes, true);
+}
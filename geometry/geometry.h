@@ -4,186 +4,495 @@
 #include <cmath>
 #include <utility>
 #include <algorithm>
+#include <cstdint>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include <span>
+#include <stdexcept>
+#include "parallel.h"
+#include "predicates.h"
 
 static constexpr double kAccuracy = 1e-9;
 
-class Line;
+// Signed Q31.32 fixed-point number. Sums and differences are exact, products and quotients
+// round toward zero at 2^-32; transcendental functions go through double.
+class Fixed64{
+private:
+    __extension__ typedef __int128 Wide;
+
+    static constexpr int kFractionBits = 32;
+    static constexpr double kScale = 4294967296.0;
+
+    int64_t raw_ = 0;
+
+public:
+    constexpr Fixed64() = default;
+
+    constexpr Fixed64(int value): raw_(static_cast<int64_t>(value) * (int64_t{1} << kFractionBits)){}
+
+    explicit Fixed64(double value): raw_(std::llround(value * kScale)){}
+
+    static constexpr Fixed64 fromRaw(int64_t raw){
+        Fixed64 result;
+        result.raw_ = raw;
+        return result;
+    }
+
+    constexpr int64_t raw() const{
+        return raw_;
+    }
+
+    explicit operator double() const{
+        return static_cast<double>(raw_) / kScale;
+    }
+
+    constexpr Fixed64 operator-() const{
+        return fromRaw(-raw_);
+    }
+
+    Fixed64& operator+=(Fixed64 another){
+        raw_ += another.raw_;
+        return *this;
+    }
+
+    Fixed64& operator-=(Fixed64 another){
+        raw_ -= another.raw_;
+        return *this;
+    }
+
+    Fixed64& operator*=(Fixed64 another){
+        raw_ = static_cast<int64_t>((static_cast<Wide>(raw_) * another.raw_) >> kFractionBits);
+        return *this;
+    }
+
+    Fixed64& operator/=(Fixed64 another){
+        raw_ = static_cast<int64_t>((static_cast<Wide>(raw_) << kFractionBits) / another.raw_);
+        return *this;
+    }
+
+    friend Fixed64 operator+(Fixed64 lhs, Fixed64 rhs){ return lhs += rhs; }
+    friend Fixed64 operator-(Fixed64 lhs, Fixed64 rhs){ return lhs -= rhs; }
+    friend Fixed64 operator*(Fixed64 lhs, Fixed64 rhs){ return lhs *= rhs; }
+    friend Fixed64 operator/(Fixed64 lhs, Fixed64 rhs){ return lhs /= rhs; }
+
+    friend constexpr bool operator==(Fixed64 lhs, Fixed64 rhs){ return lhs.raw_ == rhs.raw_; }
+    friend constexpr auto operator<=>(Fixed64 lhs, Fixed64 rhs){ return lhs.raw_ <=> rhs.raw_; }
+};
+
+// Per-scalar tolerance and math used by the geometry templates.
+template <typename T>
+struct ScalarTraits;
+
+template <typename T>
+struct FloatingScalarTraits{
+    static constexpr T kPi = static_cast<T>(M_PI);
+
+    static T sqrt(T value){ return std::sqrt(value); }
+    static T abs(T value){ return std::fabs(value); }
+    static T sin(T value){ return std::sin(value); }
+    static T cos(T value){ return std::cos(value); }
+    static T atan(T value){ return std::atan(value); }
+    static T atan2(T y, T x){ return std::atan2(y, x); }
+};
+
+template <>
+struct ScalarTraits<double>: FloatingScalarTraits<double>{
+    static constexpr double kAccuracy = ::kAccuracy;
+};
+
+template <>
+struct ScalarTraits<float>: FloatingScalarTraits<float>{
+    static constexpr float kAccuracy = 1e-4f;
+};
+
+template <>
+struct ScalarTraits<Fixed64>{
+    static constexpr Fixed64 kAccuracy = Fixed64::fromRaw(int64_t{1} << 12);
+    static constexpr Fixed64 kPi = Fixed64::fromRaw(13493037705);
+
+    static Fixed64 sqrt(Fixed64 value){ return Fixed64(std::sqrt(static_cast<double>(value))); }
+    static Fixed64 abs(Fixed64 value){ return value < 0 ? -value : value; }
+    static Fixed64 sin(Fixed64 value){ return Fixed64(std::sin(static_cast<double>(value))); }
+    static Fixed64 cos(Fixed64 value){ return Fixed64(std::cos(static_cast<double>(value))); }
+    static Fixed64 atan(Fixed64 value){ return Fixed64(std::atan(static_cast<double>(value))); }
+    static Fixed64 atan2(Fixed64 y, Fixed64 x){ return Fixed64(std::atan2(static_cast<double>(y), static_cast<double>(x))); }
+};
+
+// A value computed on first use and kept until reset(). Concurrent first calls may each compute
+// it, but only one result is published (release, paired with the acquire in get) and the rest
+// are discarded, so const callers on a shared object never race. reset() and assignment are
+// mutations and need exclusive access, like any other non-const call.
+template <typename V>
+class LazyValue{
+private:
+    mutable std::atomic<const V*> value_{nullptr};
+
+public:
+    LazyValue() = default;
+
+    LazyValue(const LazyValue& another){
+        const V* value = another.value_.load(std::memory_order_acquire);
+        if(value) value_.store(new V(*value), std::memory_order_relaxed);
+    }
+
+    LazyValue& operator=(const LazyValue& another){
+        if(this != &another){
+            const V* value = another.value_.load(std::memory_order_acquire);
+            reset();
+            if(value) value_.store(new V(*value), std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    ~LazyValue(){
+        delete value_.load(std::memory_order_relaxed);
+    }
+
+    template <typename Compute>
+    const V& get(Compute compute) const{
+        const V* current = value_.load(std::memory_order_acquire);
+        if(current) return *current;
+        const V* fresh = new V(compute());
+        if(value_.compare_exchange_strong(current, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) return *fresh;
+        delete fresh;
+        return *current;
+    }
+
+    void reset(){
+        delete value_.exchange(nullptr, std::memory_order_relaxed);
+    }
+};
+
+template <typename T>
+class BasicLine;
+
+template <typename T>
+struct BasicPoint{
+    using Traits = ScalarTraits<T>;
 
-struct Point{
-    double x = 0;
-    double y = 0;
+    T x = 0;
+    T y = 0;
 
-    Point() = default;
+    BasicPoint() = default;
 
-    Point(double px, double py): x(px), y(py){}
+    BasicPoint(T px, T py): x(px), y(py){}
 
-    double length() const{
-        return std::sqrt(length2());
+    T length() const{
+        return Traits::sqrt(length2());
     }
 
-    double length2() const{
+    T length2() const{
         return x * x + y * y;
     }
 
-    double crossProduct(const Point& another) const{
+    T crossProduct(const BasicPoint<T>& another) const{
         return x * another.y - another.x * y;
     }
 
-    Point normalize() const{
-        double len = length();
-        return Point(x / len, y / len);
+    BasicPoint<T> normalize() const{
+        T len = length();
+        return BasicPoint<T>(x / len, y / len);
     }
 
-    void rotate(const Point& center, double angle){
-        double dx = x - center.x;
-        double dy = y - center.y;
+    void rotate(const BasicPoint<T>& center, T angle){
+        T dx = x - center.x;
+        T dy = y - center.y;
 
-        double rx = dx * std::cos(angle) - dy * std::sin(angle);
-        double ry = dx * std::sin(angle) + dy * std::cos(angle);
+        T rx = dx * Traits::cos(angle) - dy * Traits::sin(angle);
+        T ry = dx * Traits::sin(angle) + dy * Traits::cos(angle);
 
         x = center.x + rx;
         y = center.y + ry;
     }
 
-    void reflect(const Point& center){
+    void reflect(const BasicPoint<T>& center){
         x = 2 * center.x - x;
         y = 2 * center.y - y;
     }
 
-    void reflect(const Line& axis);
+    void reflect(const BasicLine<T>& axis);
 
-    void scale(const Point& center, double coefficient){
+    void scale(const BasicPoint<T>& center, T coefficient){
         x = center.x + (x - center.x) * coefficient;
         y = center.y + (y - center.y) * coefficient;
     }
 
-    Point perpendicular() const{
-        return Point(-y, x);
+    BasicPoint<T> perpendicular() const{
+        return BasicPoint<T>(-y, x);
     }
 };
 
-bool operator==(const Point& lhs, const Point& rhs){
-    return std::fabs(lhs.x - rhs.x) < kAccuracy && std::fabs(lhs.y - rhs.y) < kAccuracy;
+template <typename T>
+bool operator==(const BasicPoint<T>& lhs, const BasicPoint<T>& rhs){
+    using Traits = ScalarTraits<T>;
+    return Traits::abs(lhs.x - rhs.x) < Traits::kAccuracy && Traits::abs(lhs.y - rhs.y) < Traits::kAccuracy;
 }
 
-bool operator!=(const Point& lhs, const Point& rhs){
+template <typename T>
+bool operator!=(const BasicPoint<T>& lhs, const BasicPoint<T>& rhs){
     return !(lhs == rhs);
 }
 
-Point operator+(const Point& lhs, const Point& rhs){
-    return Point(lhs.x + rhs.x, lhs.y + rhs.y);
+template <typename T>
+BasicPoint<T> operator+(const BasicPoint<T>& lhs, const BasicPoint<T>& rhs){
+    return BasicPoint<T>(lhs.x + rhs.x, lhs.y + rhs.y);
 }
 
-Point operator-(const Point& lhs, const Point& rhs){
-    return Point(lhs.x - rhs.x, lhs.y - rhs.y);
+template <typename T>
+BasicPoint<T> operator-(const BasicPoint<T>& lhs, const BasicPoint<T>& rhs){
+    return BasicPoint<T>(lhs.x - rhs.x, lhs.y - rhs.y);
 }
 
-Point operator*(const Point& p, double k){
-    return Point(p.x * k, p.y * k);
+template <typename T>
+BasicPoint<T> operator*(const BasicPoint<T>& p, std::type_identity_t<T> k){
+    return BasicPoint<T>(p.x * k, p.y * k);
 }
 
-Point operator/(const Point& p, double k){
-    return Point(p.x / k, p.y / k);
+template <typename T>
+BasicPoint<T> operator/(const BasicPoint<T>& p, std::type_identity_t<T> k){
+    return BasicPoint<T>(p.x / k, p.y / k);
 }
 
 
-class Line{
+// Sign of the turn a -> b -> c: 1 counter-clockwise, -1 clockwise, 0 collinear. Exact for
+// every scalar: floating point goes through the filtered predicates of predicates.h (float
+// converts to double without loss), Fixed64 multiplies its raw values in 128 bits.
+template <typename T>
+int orientationSign(const BasicPoint<T>& a, const BasicPoint<T>& b, const BasicPoint<T>& c){
+    if constexpr(std::is_floating_point_v<T>){
+        auto value = [](T coordinate){ return static_cast<double>(coordinate); };
+        double det = orient2d(value(a.x), value(a.y), value(b.x), value(b.y), value(c.x), value(c.y));
+        return (det > 0) - (det < 0);
+    } else{
+        __extension__ typedef __int128 Wide;
+        Wide left = static_cast<Wide>((a.x - c.x).raw()) * (b.y - c.y).raw();
+        Wide right = static_cast<Wide>((a.y - c.y).raw()) * (b.x - c.x).raw();
+        return (left > right) - (left < right);
+    }
+}
+
+// 1 when d lies strictly inside the circle through a, b, c, -1 outside, 0 on it, whichever
+// way a, b, c turn. Exact for float and double; Fixed64 is evaluated through double.
+template <typename T>
+int inCircleSign(const BasicPoint<T>& a, const BasicPoint<T>& b, const BasicPoint<T>& c, const BasicPoint<T>& d){
+    auto value = [](T coordinate){ return static_cast<double>(coordinate); };
+    double det = incircle(value(a.x), value(a.y), value(b.x), value(b.y), value(c.x), value(c.y), value(d.x), value(d.y));
+    return ((det > 0) - (det < 0)) * orientationSign(a, b, c);
+}
+
+
+template <typename T>
+class BasicLine{
 private:
-    double cA_;
-    double cB_;
-    double cC_;
+    using Traits = ScalarTraits<T>;
+
+    T cA_;
+    T cB_;
+    T cC_;
 
 public:
-    Line(const Point& p1, const Point& p2){
+    BasicLine(const BasicPoint<T>& p1, const BasicPoint<T>& p2){
         cA_ = p2.y - p1.y;
         cB_ = p1.x - p2.x;
         cC_ = -cA_ * p1.x - cB_ * p1.y;
     }
 
-    Line(const Point& point, double k): cA_(k), cB_(-1), cC_(point.y - k * point.x){}
+    BasicLine(const BasicPoint<T>& point, T k): cA_(k), cB_(-1), cC_(point.y - k * point.x){}
 
-    Line(double k, double b): cA_(k), cB_(-1), cC_(b){}
+    BasicLine(T k, T b): cA_(k), cB_(-1), cC_(b){}
 
-    bool operator==(const Line& another) const{
-        return std::fabs(cA_ * another.cB_ - cB_ * another.cA_) < kAccuracy
-            && std::fabs(cA_ * another.cC_ - cC_ * another.cA_) < kAccuracy
-            && std::fabs(cC_ * another.cB_ - cB_ * another.cC_) < kAccuracy;
+    bool operator==(const BasicLine<T>& another) const{
+        return Traits::abs(cA_ * another.cB_ - cB_ * another.cA_) < Traits::kAccuracy
+            && Traits::abs(cA_ * another.cC_ - cC_ * another.cA_) < Traits::kAccuracy
+            && Traits::abs(cC_ * another.cB_ - cB_ * another.cC_) < Traits::kAccuracy;
     }
 
-    bool operator!=(const Line& another) const{
+    bool operator!=(const BasicLine<T>& another) const{
         return !(*this == another);
     }
 
-    Point getReflectedPoint(const Point& point) const{
-        double factor = 2.0 * (cA_ * point.x + cB_ * point.y + cC_) / (cA_ * cA_ + cB_ * cB_);
-        return Point(point.x - factor * cA_, point.y - factor * cB_);
+    BasicPoint<T> getReflectedPoint(const BasicPoint<T>& point) const{
+        T factor = 2 * (cA_ * point.x + cB_ * point.y + cC_) / (cA_ * cA_ + cB_ * cB_);
+        return BasicPoint<T>(point.x - factor * cA_, point.y - factor * cB_);
     }
 
-    Point intersection(const Line& another) const{
-        double det = cA_ * another.cB_ - another.cA_ * cB_;
-        double px = (cB_ * another.cC_ - another.cB_ * cC_) / det;
-        double py = (another.cA_ * cC_ - cA_ * another.cC_) / det;
-        return Point(px, py);
+    // Near-parallel lines make the determinants cancel; floating point computes them with the
+    // rounding error of each product carried along.
+    BasicPoint<T> intersection(const BasicLine<T>& another) const{
+        auto cross = [](T a, T b, T c, T d){
+            if constexpr(std::is_same_v<T, double>) return differenceOfProducts(a, b, c, d);
+            else return a * b - c * d;
+        };
+        T det = cross(cA_, another.cB_, another.cA_, cB_);
+        T px = cross(cB_, another.cC_, another.cB_, cC_) / det;
+        T py = cross(another.cA_, cC_, cA_, another.cC_) / det;
+        return BasicPoint<T>(px, py);
     }
 };
 
-void Point::reflect(const Line& axis){
-    Point reflected = axis.getReflectedPoint(*this);
+template <typename T>
+void BasicPoint<T>::reflect(const BasicLine<T>& axis){
+    BasicPoint<T> reflected = axis.getReflectedPoint(*this);
     x = reflected.x;
     y = reflected.y;
 }
 
 
-class Shape{
+// Rotation/reflection-invariant summary of a shape used to find congruence (or similarity)
+// candidates. key is exact and hashed: shapes with different keys never match. measures are
+// continuous invariants, and two matching shapes differ in measures[i] by at most tolerances[i],
+// which is the same for every shape with the same key. With relative set the last bound depends
+// on sizes instead: a shape of the given scale s that matches a representative of scale r, with
+// s >= tolerance r, differs from it in the last measure by at most tolerance (r / s + 1), and
+// below that ratio there is no bound. seal() clears bounded when a measure or a relative scale
+// is unusable; such shapes have no bounds at all.
+struct ShapeSignature{
+    std::vector<int64_t> key;
+    std::vector<double> measures;
+    std::vector<double> tolerances;
+    bool relative = false;
+    double scale = 0;
+    bool bounded = true;
+    size_t hash = 0;
+
+    // floor(value / width), clamped well inside int64_t so that neighbours never overflow; NaN
+    // and values beyond the range share the outermost buckets.
+    static int64_t quantize(double value, double width){
+        static constexpr double kLimit = 4611686018427387904.0;
+        double index = std::floor(value / width);
+        if(!(index < kLimit)) return static_cast<int64_t>(kLimit);
+        if(index < -kLimit) return -static_cast<int64_t>(kLimit);
+        return static_cast<int64_t>(index);
+    }
+
+    static uint64_t mix(uint64_t h, int64_t value){
+        uint64_t x = static_cast<uint64_t>(value) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return h ^ x ^ (x >> 31);
+    }
+
+    // Buckets along measures[i] are four tolerances wide, so the values within one tolerance of
+    // any value span at most two of them.
+    double bucketWidth(size_t i) const{
+        return 4 * tolerances[i];
+    }
+
+    void seal(){
+        uint64_t h = 0x9e3779b97f4a7c15ull;
+        for(int64_t value : key) h = mix(h, value);
+        hash = static_cast<size_t>(h);
+        for(double measure : measures) bounded = bounded && std::isfinite(measure);
+        if(relative) bounded = bounded && std::isfinite(scale) && scale > 0;
+    }
+
+    bool sameKey(const ShapeSignature& another) const{
+        return hash == another.hash && key == another.key;
+    }
+};
+
+
+template <typename T>
+class BasicShape{
 public:
-    virtual double perimeter() const = 0;
-    virtual double area() const = 0;
+    virtual T perimeter() const = 0;
+    virtual T area() const = 0;
 
-    virtual bool operator==(const Shape& another) const = 0;
-    virtual bool isCongruentTo(const Shape& another) const = 0;
-    virtual bool isSimilarTo(const Shape& another) const = 0;
-    virtual bool containsPoint(const Point& point) const = 0;
+    virtual bool operator==(const BasicShape<T>& another) const = 0;
+    virtual bool isCongruentTo(const BasicShape<T>& another) const = 0;
+    virtual bool isSimilarTo(const BasicShape<T>& another) const = 0;
+    virtual bool containsPoint(const BasicPoint<T>& point) const = 0;
 
-    virtual void rotate(const Point& point, double angle) = 0;
-    virtual void reflect(const Point& center) = 0;
-    virtual void reflect(const Line& axis) = 0;
-    virtual void scale(const Point& center, double coefficient) = 0;
+    virtual void rotate(const BasicPoint<T>& point, T angle) = 0;
+    virtual void reflect(const BasicPoint<T>& center) = 0;
+    virtual void reflect(const BasicLine<T>& axis) = 0;
+    virtual void scale(const BasicPoint<T>& center, T coefficient) = 0;
 
-    virtual ~Shape() = default;
+    virtual ShapeSignature signature(bool similar) const = 0;
+
+    virtual ~BasicShape() = default;
 };
 
 
-class Polygon: public Shape{
+template <typename T>
+class BasicPolygon: public BasicShape<T>{
 protected:
-    std::vector<Point> vertices_;
+    using Traits = ScalarTraits<T>;
+
+    std::vector<BasicPoint<T>> vertices_;
 
-    static std::vector<double> profile(const std::vector<Point>& v){
+    // Derived quantities, computed together on first use and dropped by every mutating
+    // transform. Const calls on one BasicPolygon<T> may run concurrently.
+    struct Metrics{
+        std::vector<T> sides;
+        T perimeter = 0;
+        T area = 0;
+        bool convex = true;
+        std::pair<BasicPoint<T>, BasicPoint<T>> boundingBox;
+    };
+
+    LazyValue<Metrics> metrics_;
+
+    virtual void invalidate(){
+        metrics_.reset();
+    }
+
+    const Metrics& metrics() const{
+        return metrics_.get([this](){
+            Metrics result;
+            size_t n = vertices_.size();
+            result.sides.resize(n);
+            for(size_t i = 0; i < n; ++i){
+                result.sides[i] = (vertices_[i] - vertices_[(i + 1) % n]).length();
+                result.perimeter += result.sides[i];
+            }
+            if(n == 0) return result;
+            result.area = areaOf(vertices_.data(), n);
+            bool positive = false;
+            bool negative = false;
+            BasicPoint<T> low = vertices_[0];
+            BasicPoint<T> high = vertices_[0];
+            for(size_t i = 0; i < n; ++i){
+                int turn = orientationSign(vertices_[i], vertices_[(i + 1) % n], vertices_[(i + 2) % n]);
+                if(turn > 0) positive = true;
+                else if(turn < 0) negative = true;
+                low = BasicPoint<T>(std::min(low.x, vertices_[i].x), std::min(low.y, vertices_[i].y));
+                high = BasicPoint<T>(std::max(high.x, vertices_[i].x), std::max(high.y, vertices_[i].y));
+            }
+            result.convex = !(positive && negative);
+            result.boundingBox = std::make_pair(low, high);
+            return result;
+        });
+    }
+
+    static std::vector<T> profile(const std::vector<BasicPoint<T>>& v){
         size_t n = v.size();
-        std::vector<double> result(2 * n);
+        std::vector<T> result(2 * n);
         for(size_t i = 0; i < n; ++i){
-            Point prev = v[(i + n - 1) % n] - v[i];
-            Point next = v[(i + 1) % n] - v[i];
-            result[2 * i] = std::atan2(std::fabs(prev.crossProduct(next)), prev.x * next.x + prev.y * next.y);
+            BasicPoint<T> prev = v[(i + n - 1) % n] - v[i];
+            BasicPoint<T> next = v[(i + 1) % n] - v[i];
+            result[2 * i] = Traits::atan2(Traits::abs(prev.crossProduct(next)), prev.x * next.x + prev.y * next.y);
             result[2 * i + 1] = next.length();
         }
         return result;
     }
 
-    static bool matchProfile(const std::vector<double>& a, const std::vector<double>& b, bool similar){
+    static bool matchProfile(const std::vector<T>& a, const std::vector<T>& b, bool similar){
         size_t n = a.size();
         if(b.size() != n) return false;
         for(size_t shift = 0; shift < n; shift += 2){
-            double k = -1;
+            T k = -1;
             bool ok = true;
             for(size_t i = 0; i < n; ++i){
-                double av = a[i];
-                double bv = b[(i + shift) % n];
+                T av = a[i];
+                T bv = b[(i + shift) % n];
                 if(i % 2 == 0){
-                    if(std::fabs(av - bv) > kAccuracy){ ok = false; break; }
+                    if(Traits::abs(av - bv) > Traits::kAccuracy){ ok = false; break; }
                 } else if(similar){
                     if(k < 0) k = av / bv;
-                    if(std::fabs(av / bv - k) > kAccuracy){ ok = false; break; }
-                } else if(std::fabs(av - bv) > kAccuracy){
+                    if(Traits::abs(av / bv - k) > Traits::kAccuracy){ ok = false; break; }
+                } else if(Traits::abs(av - bv) > Traits::kAccuracy){
                     ok = false;
                     break;
                 }
@@ -193,62 +502,222 @@ protected:
         return false;
     }
 
-    bool sameShape(const Shape& another, bool similar) const{
-        const Polygon* ptr = dynamic_cast<const Polygon*>(&another);
+    bool sameShape(const BasicShape<T>& another, bool similar) const{
+        const BasicPolygon<T>* ptr = dynamic_cast<const BasicPolygon<T>*>(&another);
         if(!ptr || verticesCount() != ptr->verticesCount()) return false;
-        std::vector<Point> mine = vertices_;
-        std::vector<Point> other = ptr->vertices_;
+        std::vector<BasicPoint<T>> mine = vertices_;
+        std::vector<BasicPoint<T>> other = ptr->vertices_;
         if(matchProfile(profile(mine), profile(other), similar)) return true;
         std::reverse(other.begin(), other.end());
         return matchProfile(profile(mine), profile(other), similar);
     }
 
 public:
-    Polygon(const std::vector<Point>& points): vertices_(points){}
+    BasicPolygon(const std::vector<BasicPoint<T>>& points): vertices_(points){}
 
     template <typename ...Points>
-    Polygon(const Points& ...points): vertices_({points...}){}
+    BasicPolygon(const Points& ...points): vertices_({points...}){}
 
     size_t verticesCount() const{
         return vertices_.size();
     }
 
-    std::vector<Point> getVertices() const{
+    std::vector<BasicPoint<T>> getVertices() const{
         return vertices_;
     }
 
-    bool isConvex() const{
-        bool positive = false;
-        bool negative = false;
-        size_t n = vertices_.size();
+    // Raw-array kernels shared with containers that keep vertices outside of a Polygon.
+    static T perimeterOf(const BasicPoint<T>* vertices, size_t n){
+        T result = 0;
         for(size_t i = 0; i < n; ++i){
-            double cross = (vertices_[i] - vertices_[(i + 1) % n]).crossProduct(vertices_[(i + 1) % n] - vertices_[(i + 2) % n]);
-            if(cross > 0) positive = true;
-            else negative = true;
+            result += (vertices[i] - vertices[(i + 1) % n]).length();
         }
-        return !(positive && negative);
+        return result;
     }
 
-    double perimeter() const override{
-        double result = 0;
-        size_t n = vertices_.size();
+    static T areaOf(const BasicPoint<T>* vertices, size_t n){
+        T result = 0;
         for(size_t i = 0; i < n; ++i){
-            result += (vertices_[i] - vertices_[(i + 1) % n]).length();
+            result += (vertices[i] - vertices[0]).crossProduct(vertices[(i + 1) % n] - vertices[0]);
         }
-        return result;
+        return Traits::abs(result) / 2;
     }
 
-    double area() const override{
-        double result = 0;
-        size_t n = vertices_.size();
-        for(size_t i = 0; i < n; ++i){
-            result += (vertices_[i] - vertices_[0]).crossProduct(vertices_[(i + 1) % n] - vertices_[0]);
+    static bool containsPointOf(const BasicPoint<T>* vertices, size_t n, const BasicPoint<T>& point){
+        auto onSegment = [&](const BasicPoint<T>& a, const BasicPoint<T>& b, const BasicPoint<T>& q){
+            T cross = BasicPoint<T>{q.x - a.x, q.y - a.y}.crossProduct(BasicPoint<T>{b.x - a.x, b.y - a.y});
+            if(Traits::abs(cross) > Traits::kAccuracy) return false;
+
+            T dot = (q.x - a.x) * (b.x - a.x) + (q.y - a.y) * (b.y - a.y);
+            if(dot < -Traits::kAccuracy) return false;
+            T len2 = (b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y);
+            return dot <= len2 + Traits::kAccuracy;
+        };
+
+        bool inside = false;
+
+        for(size_t i = 0, j = n - 1; i < n; j = i++){
+            const BasicPoint<T>& a = vertices[j];
+            const BasicPoint<T>& b = vertices[i];
+
+            if(onSegment(a, b, point)) return true;
+
+            // The edge crosses the horizontal through point to its right iff point lies on the
+            // left of an upward edge or on the right of a downward one.
+            if((a.y > point.y) != (b.y > point.y)){
+                int side = orientationSign(a, b, point);
+                if(b.y > a.y ? side > 0 : side < 0){
+                    inside = !inside;
+                }
+            }
+        }
+
+        return inside;
+    }
+
+#ifdef __AVX__
+    static constexpr size_t kVectorBytes = 32;
+#else
+    static constexpr size_t kVectorBytes = 16;
+#endif
+    static constexpr size_t kVectorsPerBlock = 2;
+    static constexpr size_t kVectorLanes = kVectorBytes / sizeof(T);
+    // Two-lane double vectors lose to the scalar loop, so SSE2 builds only vectorize float.
+    static constexpr bool kVectorizeContains = std::is_floating_point_v<T> && kVectorLanes >= 4;
+    static constexpr size_t kContainsLanes = kVectorizeContains ? kVectorsPerBlock * kVectorLanes : 8;
+
+    // Classifies kContainsLanes points per pass over the edges. Per lane the boundary arithmetic
+    // is the same as in containsPointOf, in the same order, and the crossing test is exact in
+    // both, so results are identical; the boundary rule becomes a sticky mask instead of an
+    // early return. Vectorized scalars use native-width GCC vector types (SSE2, or AVX when
+    // enabled), the rest fall back to the scalar test.
+    static void containsPointsBlock(const BasicPoint<T>* vertices, size_t n, const BasicPoint<T>* points, size_t count, uint8_t* out){
+        if constexpr(kVectorizeContains){
+            typedef T Vector __attribute__((vector_size(kVectorBytes)));
+            typedef decltype(Vector() < Vector()) Mask;
+            constexpr T kEpsilonT = std::numeric_limits<T>::epsilon() / 2;
+            constexpr T kOrientationFilter = (3 + 16 * kEpsilonT) * kEpsilonT;
+            auto anyLane = [](Mask mask){
+                uint64_t words[sizeof(Mask) / sizeof(uint64_t)];
+                std::memcpy(words, &mask, sizeof(Mask));
+                uint64_t any = 0;
+                for(uint64_t word : words) any |= word;
+                return any != 0;
+            };
+
+            T xs[kContainsLanes];
+            T ys[kContainsLanes];
+            T lowY = points[0].y;
+            T highY = points[0].y;
+            for(size_t lane = 0; lane < kContainsLanes; ++lane){
+                const BasicPoint<T>& point = points[lane < count ? lane : count - 1];
+                xs[lane] = point.x;
+                ys[lane] = point.y;
+                lowY = std::min(lowY, point.y);
+                highY = std::max(highY, point.y);
+            }
+            Vector px[kVectorsPerBlock];
+            Vector py[kVectorsPerBlock];
+            std::memcpy(px, xs, sizeof(px));
+            std::memcpy(py, ys, sizeof(py));
+            Mask inside[kVectorsPerBlock] = {};
+            Mask boundary[kVectorsPerBlock] = {};
+
+            for(size_t i = 0, j = n - 1; i < n; j = i++){
+                const BasicPoint<T>& a = vertices[j];
+                const BasicPoint<T>& b = vertices[i];
+                T ex = b.x - a.x;
+                T ey = b.y - a.y;
+                T len2 = ex * ex + ey * ey;
+
+                for(size_t v = 0; v < kVectorsPerBlock; ++v){
+                    Vector qx = px[v] - a.x;
+                    Vector qy = py[v] - a.y;
+                    Vector cross = qx * ey - ex * qy;
+                    Vector dot = qx * ex + qy * ey;
+                    boundary[v] |= ~((cross > Traits::kAccuracy) | (cross < -Traits::kAccuracy))
+                        & ~(dot < -Traits::kAccuracy) & (dot <= len2 + Traits::kAccuracy);
+                }
+
+                // Most edges lie entirely above or below a block of nearby points; those cannot
+                // toggle any lane, so the crossing test is skipped for them.
+                if(std::min(a.y, b.y) > highY || std::max(a.y, b.y) <= lowY) continue;
+
+                // Lanes whose horizontal the edge crosses take the orientation filter of
+                // predicates.h, evaluated in T; what it cannot decide goes to the exact predicate.
+                Mask crosses[kVectorsPerBlock];
+                Mask crossing = {};
+                for(size_t v = 0; v < kVectorsPerBlock; ++v){
+                    crosses[v] = (py[v] < a.y) != (py[v] < b.y);
+                    crossing |= crosses[v];
+                }
+                if(!anyLane(crossing)) continue;
+                for(size_t v = 0; v < kVectorsPerBlock; ++v){
+                    Vector left = ex * (py[v] - a.y);
+                    Vector right = ey * (px[v] - a.x);
+                    Vector det = left - right;
+                    Vector bound = kOrientationFilter * ((left < 0 ? -left : left) + (right < 0 ? -right : right));
+                    Mask onLeft = det > bound;
+                    Mask onRight = det < -bound;
+                    Mask toggles = crosses[v] & (ey > 0 ? onLeft : onRight);
+                    Mask unsure = crosses[v] & ~onLeft & ~onRight & ~((det == 0) & (bound == 0));
+                    if(anyLane(unsure)){
+                        for(size_t lane = 0; lane < kVectorLanes; ++lane){
+                            if(!unsure[lane]) continue;
+                            int side = orientationSign(a, b, BasicPoint<T>(px[v][lane], py[v][lane]));
+                            if(ey > 0 ? side > 0 : side < 0) toggles[lane] = -1;
+                        }
+                    }
+                    inside[v] ^= toggles;
+                }
+            }
+
+            for(size_t lane = 0; lane < count; ++lane){
+                out[lane] = (boundary[lane / kVectorLanes][lane % kVectorLanes] | inside[lane / kVectorLanes][lane % kVectorLanes]) != 0;
+            }
+        } else{
+            for(size_t lane = 0; lane < count; ++lane) out[lane] = containsPointOf(vertices, n, points[lane]);
         }
-        return std::fabs(result) / 2;
     }
 
-    bool operator==(const Shape& another) const override{
-        const Polygon* ptr = dynamic_cast<const Polygon*>(&another);
+    // Batch containsPoint: out[i] is 1 iff points[i] is inside or on the boundary. Points are
+    // sharded across `threads` threads and classified kContainsLanes at a time. out must have
+    // room for every point, std::invalid_argument otherwise.
+    void containsPoints(std::span<const BasicPoint<T>> points, std::span<uint8_t> out, size_t threads = hardwareThreads()) const{
+        static constexpr size_t kGrain = 512 * kContainsLanes;
+        if(out.size() < points.size()) throw std::invalid_argument("containsPoints: out is shorter than points");
+        const BasicPoint<T>* vertices = vertices_.data();
+        size_t n = vertices_.size();
+        parallelFor(points.size(), kGrain, [&](size_t begin, size_t end){
+            for(size_t i = begin; i < end; i += kContainsLanes){
+                containsPointsBlock(vertices, n, points.data() + i, std::min(kContainsLanes, end - i), out.data() + i);
+            }
+        }, threads);
+    }
+
+    // sideLengths()[i] is the distance from vertex i to vertex i + 1.
+    const std::vector<T>& sideLengths() const{
+        return metrics().sides;
+    }
+
+    std::pair<BasicPoint<T>, BasicPoint<T>> boundingBox() const{
+        return metrics().boundingBox;
+    }
+
+    bool isConvex() const{
+        return metrics().convex;
+    }
+
+    T perimeter() const override{
+        return metrics().perimeter;
+    }
+
+    T area() const override{
+        return metrics().area;
+    }
+
+    bool operator==(const BasicShape<T>& another) const override{
+        const BasicPolygon<T>* ptr = dynamic_cast<const BasicPolygon<T>*>(&another);
         if(!ptr || verticesCount() != ptr->verticesCount()) return false;
         size_t n = verticesCount();
         for(int dir = 0; dir < 2; ++dir){
@@ -264,155 +733,192 @@ public:
         return false;
     }
 
-    bool isCongruentTo(const Shape& another) const override{
+    bool isCongruentTo(const BasicShape<T>& another) const override{
         return sameShape(another, false);
     }
 
-    bool isSimilarTo(const Shape& another) const override{
+    bool isSimilarTo(const BasicShape<T>& another) const override{
         return sameShape(another, true);
     }
 
-    bool containsPoint(const Point& point) const override{
-        size_t n = vertices_.size();
-
-        auto onSegment = [&](const Point& a, const Point& b, const Point& q){
-            double cross = Point{q.x - a.x, q.y - a.y}.crossProduct(Point{b.x - a.x, b.y - a.y});
-            if(std::fabs(cross) > kAccuracy) return false;
-
-            double dot = (q.x - a.x) * (b.x - a.x) + (q.y - a.y) * (b.y - a.y);
-            if(dot < -kAccuracy) return false;
-            double len2 = (b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y);
-            return dot <= len2 + kAccuracy;
-        };
-
-        bool inside = false;
-
-        for(size_t i = 0, j = n - 1; i < n; j = i++){
-            const Point& a = vertices_[j];
-            const Point& b = vertices_[i];
-
-            if(onSegment(a, b, point)) return true;
-
-            if((a.y > point.y) != (b.y > point.y)){
-                double xIntersect = a.x + (b.x - a.x) * (point.y - a.y) / (b.y - a.y);
-                if(xIntersect > point.x - kAccuracy){
-                    inside = !inside;
-                }
-            }
+    // matchProfile lets every angle, and every side (congruence) or side ratio (similarity),
+    // differ by kAccuracy, so the extreme angles and sides move by at most as much; the bounds
+    // are doubled against rounding. For similarity with scale factor k, the ratio of the
+    // shortest to the longest side moves by at most 2 kAccuracy / (k - kAccuracy), which the
+    // relative bound covers once k is above 8 kAccuracy. Side ratios are meaningless with a
+    // zero side, so such polygons get no bounds.
+    ShapeSignature signature(bool similar) const override{
+        ShapeSignature result;
+        size_t n = verticesCount();
+        result.key = {0, static_cast<int64_t>(n)};
+        std::vector<T> values = profile(vertices_);
+        double minAngle = HUGE_VAL, maxAngle = -HUGE_VAL, minSide = HUGE_VAL, maxSide = -HUGE_VAL;
+        for(size_t i = 0; i < values.size(); i += 2){
+            double angle = static_cast<double>(values[i]);
+            double side = static_cast<double>(values[i + 1]);
+            if(!std::isfinite(angle) || !std::isfinite(side)) result.bounded = false;
+            minAngle = std::min(minAngle, angle);
+            maxAngle = std::max(maxAngle, angle);
+            minSide = std::min(minSide, side);
+            maxSide = std::max(maxSide, side);
+        }
+        double accuracy = 2 * static_cast<double>(Traits::kAccuracy);
+        result.measures = {maxAngle, minAngle};
+        result.tolerances = {accuracy, accuracy};
+        if(similar){
+            result.measures.push_back(minSide / maxSide);
+            result.tolerances.push_back(4 * accuracy);
+            result.relative = true;
+            result.scale = minSide > 0 ? maxSide : 0;
+        } else{
+            result.measures.insert(result.measures.end(), {minSide, maxSide});
+            result.tolerances.insert(result.tolerances.end(), {accuracy, accuracy});
         }
+        result.seal();
+        return result;
+    }
 
-        return inside;
+    bool containsPoint(const BasicPoint<T>& point) const override{
+        return containsPointOf(vertices_.data(), vertices_.size(), point);
     }
 
-    void rotate(const Point& point, double angle) override{
-        for(Point& vertex : vertices_) vertex.rotate(point, angle);
+    void rotate(const BasicPoint<T>& point, T angle) override{
+        for(BasicPoint<T>& vertex : vertices_) vertex.rotate(point, angle);
+        invalidate();
     }
 
-    void reflect(const Point& center) override{
-        for(Point& vertex : vertices_) vertex.reflect(center);
+    void reflect(const BasicPoint<T>& center) override{
+        for(BasicPoint<T>& vertex : vertices_) vertex.reflect(center);
+        invalidate();
     }
 
-    void reflect(const Line& axis) override{
-        for(Point& vertex : vertices_) vertex.reflect(axis);
+    void reflect(const BasicLine<T>& axis) override{
+        for(BasicPoint<T>& vertex : vertices_) vertex.reflect(axis);
+        invalidate();
     }
 
-    void scale(const Point& center, double coefficient) override{
-        for(Point& vertex : vertices_) vertex.scale(center, coefficient);
+    void scale(const BasicPoint<T>& center, T coefficient) override{
+        for(BasicPoint<T>& vertex : vertices_) vertex.scale(center, coefficient);
+        invalidate();
     }
 };
 
 
-class Ellipse: public Shape{
+template <typename T>
+class BasicEllipse: public BasicShape<T>{
 protected:
-    Point focus1_;
-    Point focus2_;
-    double diameter_;
+    using Traits = ScalarTraits<T>;
+
+    BasicPoint<T> focus1_;
+    BasicPoint<T> focus2_;
+    T diameter_;
 
-    double majorAxis() const{
+    T majorAxis() const{
         return diameter_ / 2;
     }
 
-    double minorAxis() const{
-        return std::sqrt(diameter_ * diameter_ - (focus1_ - focus2_).length2()) / 2;
+    T minorAxis() const{
+        return Traits::sqrt(diameter_ * diameter_ - (focus1_ - focus2_).length2()) / 2;
     }
 
 public:
-    Ellipse(const Point& focus1, const Point& focus2, double diameter): focus1_(focus1), focus2_(focus2), diameter_(diameter){}
+    BasicEllipse(const BasicPoint<T>& focus1, const BasicPoint<T>& focus2, T diameter): focus1_(focus1), focus2_(focus2), diameter_(diameter){}
+
+    T diameter() const{
+        return diameter_;
+    }
 
-    std::pair<Point, Point> focuses() const{
+    std::pair<BasicPoint<T>, BasicPoint<T>> focuses() const{
         return std::make_pair(focus1_, focus2_);
     }
 
-    Point center() const{
+    BasicPoint<T> center() const{
         return (focus1_ + focus2_) / 2;
     }
 
-    double eccentricity() const{
-        return std::sqrt(1 - minorAxis() * minorAxis() / (majorAxis() * majorAxis()));
+    T eccentricity() const{
+        return Traits::sqrt(1 - minorAxis() * minorAxis() / (majorAxis() * majorAxis()));
     }
 
-    std::pair<Line, Line> directrices() const{
-        Point mid = center();
-        double dist = majorAxis() / eccentricity();
-        Point direction = (focus2_ - focus1_).normalize();
-        Point perp = direction.perpendicular();
+    std::pair<BasicLine<T>, BasicLine<T>> directrices() const{
+        BasicPoint<T> mid = center();
+        T dist = majorAxis() / eccentricity();
+        BasicPoint<T> direction = (focus2_ - focus1_).normalize();
+        BasicPoint<T> perp = direction.perpendicular();
 
-        Point first = mid + direction * dist;
-        Point second = mid - direction * dist;
-        return std::make_pair(Line(first, first + perp), Line(second, second + perp));
+        BasicPoint<T> first = mid + direction * dist;
+        BasicPoint<T> second = mid - direction * dist;
+        return std::make_pair(BasicLine<T>(first, first + perp), BasicLine<T>(second, second + perp));
     }
 
-    double perimeter() const override{
-        double a = majorAxis();
-        double b = minorAxis();
-        return M_PI * (3 * (a + b) - std::sqrt((3 * a + b) * (a + 3 * b)));
+    T perimeter() const override{
+        T a = majorAxis();
+        T b = minorAxis();
+        return Traits::kPi * (3 * (a + b) - Traits::sqrt((3 * a + b) * (a + 3 * b)));
     }
 
-    double area() const override{
-        return M_PI * majorAxis() * minorAxis();
+    T area() const override{
+        return Traits::kPi * majorAxis() * minorAxis();
     }
 
-    bool operator==(const Shape& another) const override{
-        const Ellipse* ptr = dynamic_cast<const Ellipse*>(&another);
+    bool operator==(const BasicShape<T>& another) const override{
+        const BasicEllipse<T>* ptr = dynamic_cast<const BasicEllipse<T>*>(&another);
         if(!ptr) return false;
         return ((focus1_ == ptr->focus1_ && focus2_ == ptr->focus2_)
             || (focus1_ == ptr->focus2_ && focus2_ == ptr->focus1_))
-            && std::fabs(diameter_ - ptr->diameter_) < kAccuracy;
+            && Traits::abs(diameter_ - ptr->diameter_) < Traits::kAccuracy;
     }
 
-    bool isCongruentTo(const Shape& another) const override{
-        const Ellipse* ptr = dynamic_cast<const Ellipse*>(&another);
+    bool isCongruentTo(const BasicShape<T>& another) const override{
+        const BasicEllipse<T>* ptr = dynamic_cast<const BasicEllipse<T>*>(&another);
         if(!ptr) return false;
-        return std::fabs(diameter_ - ptr->diameter_) < kAccuracy
-            && std::fabs((focus1_ - focus2_).length2() - (ptr->focus1_ - ptr->focus2_).length2()) < kAccuracy;
+        return Traits::abs(diameter_ - ptr->diameter_) < Traits::kAccuracy
+            && Traits::abs((focus1_ - focus2_).length2() - (ptr->focus1_ - ptr->focus2_).length2()) < Traits::kAccuracy;
     }
 
-    bool isSimilarTo(const Shape& another) const override{
-        const Ellipse* ptr = dynamic_cast<const Ellipse*>(&another);
+    bool isSimilarTo(const BasicShape<T>& another) const override{
+        const BasicEllipse<T>* ptr = dynamic_cast<const BasicEllipse<T>*>(&another);
         if(!ptr) return false;
-        return std::fabs(eccentricity() - ptr->eccentricity()) < kAccuracy;
+        return Traits::abs(eccentricity() - ptr->eccentricity()) < Traits::kAccuracy;
     }
 
-    bool containsPoint(const Point& point) const override{
-        return (focus1_ - point).length() + (focus2_ - point).length() < diameter_ + kAccuracy;
+    // isSimilarTo compares eccentricities, and isCongruentTo diameters and squared focal
+    // distances, within kAccuracy, doubled here against rounding.
+    ShapeSignature signature(bool similar) const override{
+        ShapeSignature result;
+        result.key.push_back(1);
+        double accuracy = 2 * static_cast<double>(Traits::kAccuracy);
+        if(similar){
+            result.measures = {static_cast<double>(eccentricity())};
+            result.tolerances = {accuracy};
+        } else{
+            result.measures = {static_cast<double>((focus1_ - focus2_).length2()), static_cast<double>(diameter_)};
+            result.tolerances = {accuracy, accuracy};
+        }
+        result.seal();
+        return result;
     }
 
-    void rotate(const Point& point, double angle) override{
+    bool containsPoint(const BasicPoint<T>& point) const override{
+        return (focus1_ - point).length() + (focus2_ - point).length() < diameter_ + Traits::kAccuracy;
+    }
+
+    void rotate(const BasicPoint<T>& point, T angle) override{
         focus1_.rotate(point, angle);
         focus2_.rotate(point, angle);
     }
 
-    void reflect(const Point& center) override{
+    void reflect(const BasicPoint<T>& center) override{
         focus1_.reflect(center);
         focus2_.reflect(center);
     }
 
-    void reflect(const Line& axis) override{
+    void reflect(const BasicLine<T>& axis) override{
         focus1_.reflect(axis);
         focus2_.reflect(axis);
     }
 
-    void scale(const Point& center, double coefficient) override{
+    void scale(const BasicPoint<T>& center, T coefficient) override{
         focus1_.scale(center, coefficient);
         focus2_.scale(center, coefficient);
         diameter_ *= coefficient;
@@ -420,34 +926,45 @@ public:
 };
 
 
-class Circle final: public Ellipse{
+template <typename T>
+class BasicCircle final: public BasicEllipse<T>{
+protected:
+    using Traits = ScalarTraits<T>;
+    using BasicEllipse<T>::diameter_;
+
 public:
-    Circle(const Point& center, double radius): Ellipse(center, center, 2 * radius){}
+    BasicCircle(const BasicPoint<T>& center, T radius): BasicEllipse<T>(center, center, 2 * radius){}
 
-    double radius() const{
+    T radius() const{
         return diameter_ / 2;
     }
 
-    double perimeter() const override{
-        return 2 * M_PI * radius();
+    T perimeter() const override{
+        return 2 * Traits::kPi * radius();
     }
 
-    double area() const override{
-        return M_PI * radius() * radius();
+    T area() const override{
+        return Traits::kPi * radius() * radius();
     }
 };
 
 
-class Rectangle: public Polygon{
+template <typename T>
+class BasicRectangle: public BasicPolygon<T>{
+protected:
+    using Traits = ScalarTraits<T>;
+    using BasicPolygon<T>::vertices_;
+
 public:
-    using Polygon::Polygon;
+    using BasicPolygon<T>::BasicPolygon;
+    using BasicPolygon<T>::sideLengths;
 
-    Rectangle(const Point& p1, const Point& p2, double ratio): Polygon(std::vector<Point>(4)){
-        Point mid = (p1 + p2) / 2;
-        double angle = 2 * std::atan(ratio);
+    BasicRectangle(const BasicPoint<T>& p1, const BasicPoint<T>& p2, T ratio): BasicPolygon<T>(std::vector<BasicPoint<T>>(4)){
+        BasicPoint<T> mid = (p1 + p2) / 2;
+        T angle = 2 * Traits::atan(ratio);
 
-        Point v1 = p1;
-        Point v3 = p2;
+        BasicPoint<T> v1 = p1;
+        BasicPoint<T> v3 = p2;
         v1.rotate(mid, angle);
         v3.rotate(mid, angle);
 
@@ -457,95 +974,165 @@ public:
         vertices_[3] = v3;
     }
 
-    Point center() const{
-        std::pair<Line, Line> d = diagonals();
+    BasicPoint<T> center() const{
+        std::pair<BasicLine<T>, BasicLine<T>> d = diagonals();
         return d.first.intersection(d.second);
     }
 
-    std::pair<Line, Line> diagonals() const{
-        return std::make_pair(Line(vertices_[0], vertices_[2]), Line(vertices_[1], vertices_[3]));
+    std::pair<BasicLine<T>, BasicLine<T>> diagonals() const{
+        return std::make_pair(BasicLine<T>(vertices_[0], vertices_[2]), BasicLine<T>(vertices_[1], vertices_[3]));
     }
 
-    double perimeter() const override{
-        return 2 * ((vertices_[0] - vertices_[1]).length() + (vertices_[1] - vertices_[2]).length());
+    T perimeter() const override{
+        return 2 * (sideLengths()[0] + sideLengths()[1]);
     }
 
-    double area() const override{
-        return (vertices_[0] - vertices_[1]).length() * (vertices_[1] - vertices_[2]).length();
+    T area() const override{
+        return sideLengths()[0] * sideLengths()[1];
     }
 };
 
 
-class Square final: public Rectangle{
+template <typename T>
+class BasicSquare final: public BasicRectangle<T>{
+protected:
+    using BasicPolygon<T>::vertices_;
+
 public:
-    using Rectangle::Rectangle;
+    using BasicRectangle<T>::BasicRectangle;
 
-    Square(const Point& p1, const Point& p2): Rectangle(p1, p2, 1.0){}
+    BasicSquare(const BasicPoint<T>& p1, const BasicPoint<T>& p2): BasicRectangle<T>(p1, p2, T(1)){}
 
-    Circle circumscribedCircle() const{
-        Point mid = (vertices_[0] + vertices_[2]) / 2;
-        return Circle(mid, (vertices_[0] - mid).length());
+    BasicCircle<T> circumscribedCircle() const{
+        BasicPoint<T> mid = (vertices_[0] + vertices_[2]) / 2;
+        return BasicCircle<T>(mid, (vertices_[0] - mid).length());
     }
 
-    Circle inscribedCircle() const{
-        Point mid = (vertices_[0] + vertices_[2]) / 2;
-        return Circle(mid, (vertices_[0] - vertices_[1]).length() / 2);
+    BasicCircle<T> inscribedCircle() const{
+        BasicPoint<T> mid = (vertices_[0] + vertices_[2]) / 2;
+        return BasicCircle<T>(mid, (vertices_[0] - vertices_[1]).length() / 2);
     }
 };
 
 
-class Triangle final: public Polygon{
+template <typename T>
+class BasicTriangle final: public BasicPolygon<T>{
+private:
+    using Traits = ScalarTraits<T>;
+    using BasicPolygon<T>::vertices_;
+
+    // Cached like the polygon metrics, but each on its own, so that asking for one never
+    // divides by zero for another on a degenerate Fixed64 triangle.
+    LazyValue<BasicCircle<T>> circumscribed_;
+    LazyValue<BasicCircle<T>> inscribed_;
+    LazyValue<BasicPoint<T>> orthocenter_;
+
+    void invalidate() override{
+        BasicPolygon<T>::invalidate();
+        circumscribed_.reset();
+        inscribed_.reset();
+        orthocenter_.reset();
+    }
+
 public:
-    using Polygon::Polygon;
+    using BasicPolygon<T>::BasicPolygon;
+    using BasicPolygon<T>::sideLengths;
+    using BasicPolygon<T>::perimeter;
+
+    BasicCircle<T> circumscribedCircle() const{
+        return circumscribed_.get([this](){
+            BasicPoint<T> mid1 = (vertices_[0] + vertices_[1]) / 2;
+            BasicPoint<T> mid2 = (vertices_[1] + vertices_[2]) / 2;
 
-    Circle circumscribedCircle() const{
-        Point mid1 = (vertices_[0] + vertices_[1]) / 2;
-        Point mid2 = (vertices_[1] + vertices_[2]) / 2;
+            BasicPoint<T> perp1 = (vertices_[0] - vertices_[1]).perpendicular();
+            BasicPoint<T> perp2 = (vertices_[1] - vertices_[2]).perpendicular();
 
-        Point perp1 = (vertices_[0] - vertices_[1]).perpendicular();
-        Point perp2 = (vertices_[1] - vertices_[2]).perpendicular();
+            BasicPoint<T> mid = BasicLine<T>(mid1, mid1 + perp1).intersection(BasicLine<T>(mid2, mid2 + perp2));
+            return BasicCircle<T>(mid, (mid - vertices_[0]).length());
+        });
+    }
 
-        Point mid = Line(mid1, mid1 + perp1).intersection(Line(mid2, mid2 + perp2));
-        return Circle(mid, (mid - vertices_[0]).length());
+    BasicCircle<T> inscribedCircle() const{
+        return inscribed_.get([this](){
+            const std::vector<T>& sides = sideLengths();
+            T a = sides[1];
+            T b = sides[2];
+            T c = sides[0];
+            BasicPoint<T> incenter = (vertices_[0] * a + vertices_[1] * b + vertices_[2] * c) / (a + b + c);
+            return BasicCircle<T>(incenter, 2 * area() / perimeter());
+        });
     }
 
-    Circle inscribedCircle() const{
-        double a = (vertices_[1] - vertices_[2]).length();
-        double b = (vertices_[0] - vertices_[2]).length();
-        double c = (vertices_[0] - vertices_[1]).length();
-        Point incenter = (vertices_[0] * a + vertices_[1] * b + vertices_[2] * c) / (a + b + c);
-        return Circle(incenter, 2 * area() / perimeter());
+    // Whether point lies inside or on the circumscribed circle, decided exactly instead of by
+    // comparing distances to the rounded center.
+    bool circumscribedCircleContains(const BasicPoint<T>& point) const{
+        return inCircleSign(vertices_[0], vertices_[1], vertices_[2], point) >= 0;
     }
 
-    Point centroid() const{
+    BasicPoint<T> centroid() const{
         return (vertices_[0] + vertices_[1] + vertices_[2]) / 3;
     }
 
-    Point orthocenter() const{
-        Point perp_bc = (vertices_[2] - vertices_[1]).perpendicular();
-        Line altitude_a(vertices_[0], vertices_[0] + perp_bc);
+    BasicPoint<T> orthocenter() const{
+        return orthocenter_.get([this](){
+            BasicPoint<T> perp_bc = (vertices_[2] - vertices_[1]).perpendicular();
+            BasicLine<T> altitude_a(vertices_[0], vertices_[0] + perp_bc);
 
-        Point perp_ac = (vertices_[2] - vertices_[0]).perpendicular();
-        Line altitude_b(vertices_[1], vertices_[1] + perp_ac);
+            BasicPoint<T> perp_ac = (vertices_[2] - vertices_[0]).perpendicular();
+            BasicLine<T> altitude_b(vertices_[1], vertices_[1] + perp_ac);
 
-        return altitude_a.intersection(altitude_b);
+            return altitude_a.intersection(altitude_b);
+        });
     }
 
-    Circle ninePointsCircle() const{
-        Circle circle = circumscribedCircle();
-        Point mid = (orthocenter() + circle.center()) / 2;
-        return Circle(mid, circle.radius() / 2);
+    BasicCircle<T> ninePointsCircle() const{
+        BasicCircle<T> circle = circumscribedCircle();
+        BasicPoint<T> mid = (orthocenter() + circle.center()) / 2;
+        return BasicCircle<T>(mid, circle.radius() / 2);
     }
 
-    Line EulerLine() const{
-        return Line(orthocenter(), circumscribedCircle().center());
+    BasicLine<T> EulerLine() const{
+        return BasicLine<T>(orthocenter(), circumscribedCircle().center());
     }
 
-    double area() const override{
-        double a = (vertices_[0] - vertices_[1]).length();
-        double b = (vertices_[1] - vertices_[2]).length();
-        double c = (vertices_[2] - vertices_[0]).length();
-        double p = (a + b + c) / 2;
-        return std::sqrt(p * (p - a) * (p - b) * (p - c));
+    T area() const override{
+        const std::vector<T>& sides = sideLengths();
+        T a = sides[0];
+        T b = sides[1];
+        T c = sides[2];
+        T p = (a + b + c) / 2;
+        return Traits::sqrt(p * (p - a) * (p - b) * (p - c));
     }
 };
+
+
+// The float and double shapes are instantiated once, in instantiations.cpp, which every
+// program using them links; elsewhere only the members the compiler inlines are generated.
+extern template struct BasicPoint<float>;
+extern template class BasicLine<float>;
+extern template class BasicPolygon<float>;
+extern template class BasicEllipse<float>;
+extern template class BasicCircle<float>;
+extern template class BasicRectangle<float>;
+extern template class BasicSquare<float>;
+extern template class BasicTriangle<float>;
+
+extern template struct BasicPoint<double>;
+extern template class BasicLine<double>;
+extern template class BasicPolygon<double>;
+extern template class BasicEllipse<double>;
+extern template class BasicCircle<double>;
+extern template class BasicRectangle<double>;
+extern template class BasicSquare<double>;
+extern template class BasicTriangle<double>;
+
+// The original names stay the double instantiation.
+using Point = BasicPoint<double>;
+using Line = BasicLine<double>;
+using Shape = BasicShape<double>;
+using Polygon = BasicPolygon<double>;
+using Ellipse = BasicEllipse<double>;
+using Circle = BasicCircle<double>;
+using Rectangle = BasicRectangle<double>;
+using Square = BasicSquare<double>;
+using Triangle = BasicTriangle<double>;
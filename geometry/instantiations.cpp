@@ -0,0 +1,21 @@
+#include "geometry.h"
+
+// Explicit instantiation definitions for the extern template declarations in geometry.h: every
+// member of the float and double shapes is compiled here, once, not only those a caller uses.
+template struct BasicPoint<float>;
+template class BasicLine<float>;
+template class BasicPolygon<float>;
+template class BasicEllipse<float>;
+template class BasicCircle<float>;
+template class BasicRectangle<float>;
+template class BasicSquare<float>;
+template class BasicTriangle<float>;
+
+template struct BasicPoint<double>;
+template class BasicLine<double>;
+template class BasicPolygon<double>;
+template class BasicEllipse<double>;
+template class BasicCircle<double>;
+template class BasicRectangle<double>;
+template class BasicSquare<double>;
+template class BasicTriangle<double>;
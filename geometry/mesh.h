@@ -0,0 +1,217 @@
+#pragma once
+#include "geometry.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+// Indexed triangle mesh: a shared vertex array plus one index triple per triangle. Indices
+// must be below vertices.size().
+template <typename T>
+struct BasicTriangleMesh{
+    std::vector<BasicPoint<T>> vertices;
+    std::vector<std::array<uint32_t, 3>> triangles;
+
+    size_t size() const{
+        return triangles.size();
+    }
+
+    BasicTriangle<T> triangle(size_t index) const{
+        const std::array<uint32_t, 3>& t = triangles[index];
+        return BasicTriangle<T>(std::vector<BasicPoint<T>>{vertices[t[0]], vertices[t[1]], vertices[t[2]]});
+    }
+};
+
+// Per-triangle results of analyzeMesh, one entry per triangle in mesh order. They agree with
+// the BasicTriangle methods within kAccuracy-relative rounding; area comes from the cross
+// product instead of Heron's formula. quality is the radius ratio 2 * inradius / circumradius,
+// 1 for an equilateral triangle and approaching 0 as it degenerates. A degenerate triangle has
+// zero area and non-finite circumcenter, circumradius and orthocenter in floating point; with
+// Fixed64 it divides by zero, so such meshes must not contain one.
+template <typename T>
+struct BasicMeshMetrics{
+    std::vector<T> area;
+    std::vector<T> circumradius;
+    std::vector<T> inradius;
+    std::vector<T> quality;
+    std::vector<BasicPoint<T>> circumcenter;
+    std::vector<BasicPoint<T>> incenter;
+    std::vector<BasicPoint<T>> centroid;
+    std::vector<BasicPoint<T>> orthocenter;
+
+    void resize(size_t count){
+        for(std::vector<T>* values : {&area, &circumradius, &inradius, &quality}) values->resize(count);
+        for(std::vector<BasicPoint<T>>* points : {&circumcenter, &incenter, &centroid, &orthocenter}) points->resize(count);
+    }
+};
+
+#ifdef __AVX__
+static constexpr size_t kMeshVectorBytes = 32;
+#else
+static constexpr size_t kMeshVectorBytes = 16;
+#endif
+
+// The kernel formulas are written once for a lane type: a native GCC vector of float or double,
+// Fixed64 itself otherwise.
+template <typename T>
+struct MeshLane{
+    typedef T Type;
+};
+
+template <>
+struct MeshLane<double>{
+    typedef double Type __attribute__((vector_size(kMeshVectorBytes)));
+};
+
+template <>
+struct MeshLane<float>{
+    typedef float Type __attribute__((vector_size(kMeshVectorBytes)));
+};
+
+template <typename T>
+class MeshKernel{
+private:
+    using Traits = ScalarTraits<T>;
+    using Lane = typename MeshLane<T>::Type;
+
+    static constexpr bool kVectorize = std::is_floating_point_v<T>;
+
+public:
+    // Triangles per pass.
+    static constexpr size_t kLanes = sizeof(Lane) / sizeof(T);
+
+private:
+    static Lane sqrt(Lane value){
+        if constexpr(!kVectorize){
+            return Traits::sqrt(value);
+        } else{
+#if defined(__AVX__)
+            if constexpr(std::is_same_v<T, double>) return (Lane)_mm256_sqrt_pd((__m256d)value);
+            else return (Lane)_mm256_sqrt_ps((__m256)value);
+#elif defined(__SSE2__)
+            if constexpr(std::is_same_v<T, double>) return (Lane)_mm_sqrt_pd((__m128d)value);
+            else return (Lane)_mm_sqrt_ps((__m128)value);
+#else
+            for(size_t lane = 0; lane < kLanes; ++lane) value[lane] = Traits::sqrt(value[lane]);
+            return value;
+#endif
+        }
+    }
+
+    static Lane abs(Lane value){
+        if constexpr(!kVectorize) return Traits::abs(value);
+        else return value < 0 ? -value : value;
+    }
+
+    static Lane load(const T* values){
+        Lane lane;
+        std::memcpy(&lane, values, sizeof(Lane));
+        return lane;
+    }
+
+    static void store(T* values, Lane lane){
+        std::memcpy(values, &lane, sizeof(Lane));
+    }
+
+public:
+    // Fills results [first, first + count) for the mesh triangles starting at first, count <= kLanes.
+    // Short blocks repeat their last triangle in the unused lanes.
+    static void block(const BasicTriangleMesh<T>& mesh, size_t first, size_t count, BasicMeshMetrics<T>& out){
+        T coordinates[6][kLanes];
+        for(size_t lane = 0; lane < kLanes; ++lane){
+            const std::array<uint32_t, 3>& t = mesh.triangles[first + std::min(lane, count - 1)];
+            for(size_t k = 0; k < 3; ++k){
+                coordinates[2 * k][lane] = mesh.vertices[t[k]].x;
+                coordinates[2 * k + 1][lane] = mesh.vertices[t[k]].y;
+            }
+        }
+        Lane ax = load(coordinates[0]);
+        Lane ay = load(coordinates[1]);
+
+        // Everything is taken relative to a, which keeps the products small for meshes far
+        // from the origin. u = b - a, v = c - a.
+        Lane ux = load(coordinates[2]) - ax;
+        Lane uy = load(coordinates[3]) - ay;
+        Lane vx = load(coordinates[4]) - ax;
+        Lane vy = load(coordinates[5]) - ay;
+        Lane cross = ux * vy - vx * uy;
+        Lane u2 = ux * ux + uy * uy;
+        Lane v2 = vx * vx + vy * vy;
+        Lane wx = vx - ux;
+        Lane wy = vy - uy;
+
+        // Side lengths named as in BasicTriangle::inscribedCircle: a opposite vertex 0.
+        Lane sideA = sqrt(wx * wx + wy * wy);
+        Lane sideB = sqrt(v2);
+        Lane sideC = sqrt(u2);
+        Lane perimeter = sideA + sideB + sideC;
+        Lane area = abs(cross) / 2;
+
+        // Circumcenter o relative to a solves 2 o.u = |u|^2, 2 o.v = |v|^2.
+        Lane ox = (vy * u2 - uy * v2) / (2 * cross);
+        Lane oy = (ux * v2 - vx * u2) / (2 * cross);
+        // abc / 4S needs no fourth square root and stays in range where |o - a|^2 would not.
+        Lane circumradius = sideA * sideB * sideC / (2 * abs(cross));
+        Lane inradius = 2 * area / perimeter;
+
+        Lane results[4][2];
+        results[0][0] = ax + ox;
+        results[0][1] = ay + oy;
+        results[1][0] = ax + (ux * sideB + vx * sideC) / perimeter;
+        results[1][1] = ay + (uy * sideB + vy * sideC) / perimeter;
+        results[2][0] = ax + (ux + vx) / 3;
+        results[2][1] = ay + (uy + vy) / 3;
+        // Euler: h - a = (b - a) + (c - a) - 2 (o - a).
+        results[3][0] = ax + (ux + vx - 2 * ox);
+        results[3][1] = ay + (uy + vy - 2 * oy);
+
+        T scalars[4][kLanes];
+        store(scalars[0], area);
+        store(scalars[1], circumradius);
+        store(scalars[2], inradius);
+        store(scalars[3], 2 * inradius / circumradius);
+        T points[4][2][kLanes];
+        for(size_t k = 0; k < 4; ++k){
+            store(points[k][0], results[k][0]);
+            store(points[k][1], results[k][1]);
+        }
+
+        std::vector<T>* scalarOut[4] = {&out.area, &out.circumradius, &out.inradius, &out.quality};
+        std::vector<BasicPoint<T>>* pointOut[4] = {&out.circumcenter, &out.incenter, &out.centroid, &out.orthocenter};
+        for(size_t lane = 0; lane < count; ++lane){
+            for(size_t k = 0; k < 4; ++k){
+                (*scalarOut[k])[first + lane] = scalars[k][lane];
+                (*pointOut[k])[first + lane] = BasicPoint<T>(points[k][0][lane], points[k][1][lane]);
+            }
+        }
+    }
+};
+
+// All metrics of every mesh triangle in one pass over the index triples, sharded across
+// `threads` threads (one per core by default) and evaluated MeshKernel<T>::kLanes triangles at
+// a time. Reusing out across calls keeps its buffers, which for large meshes saves as much time
+// as the computation itself takes.
+template <typename T>
+void analyzeMesh(const BasicTriangleMesh<T>& mesh, BasicMeshMetrics<T>& out, size_t threads = hardwareThreads()){
+    static constexpr size_t kLanes = MeshKernel<T>::kLanes;
+    static constexpr size_t kGrain = 1024 * kLanes;
+    out.resize(mesh.size());
+    parallelFor(mesh.size(), kGrain, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i += kLanes){
+            MeshKernel<T>::block(mesh, i, std::min(kLanes, end - i), out);
+        }
+    }, threads);
+}
+
+template <typename T>
+BasicMeshMetrics<T> analyzeMesh(const BasicTriangleMesh<T>& mesh){
+    BasicMeshMetrics<T> result;
+    analyzeMesh(mesh, result);
+    return result;
+}
+
+using TriangleMesh = BasicTriangleMesh<double>;
+using MeshMetrics = BasicMeshMetrics<double>;
@@ -0,0 +1,38 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+inline size_t hardwareThreads(){
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Runs func(begin, end) over [0, count) in chunks of `grain`, handing chunks out to up to
+// `threads` threads (one per core by default) through a shared counter so uneven chunks
+// balance themselves.
+template <typename Func>
+void parallelFor(size_t count, size_t grain, Func func, size_t threads = hardwareThreads()){
+    if(count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    size_t chunks = (count + grain - 1) / grain;
+    threads = std::clamp<size_t>(threads, 1, chunks);
+    if(threads == 1){
+        func(size_t{0}, count);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&](){
+        for(size_t chunk = next++; chunk < chunks; chunk = next++){
+            size_t begin = chunk * grain;
+            func(begin, std::min(count, begin + grain));
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for(size_t i = 1; i < threads; ++i) pool.emplace_back(worker);
+    worker();
+    for(std::thread& thread : pool) thread.join();
+}
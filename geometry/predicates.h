@@ -0,0 +1,229 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+// Robust orientation and in-circle predicates for double coordinates, after Shewchuk,
+// "Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates".
+// The determinant is first evaluated in plain floating point together with a bound on its
+// rounding error; only when the bound does not settle the sign is it refined with exact
+// floating-point expansions (sums of non-overlapping doubles, smallest first). The returned
+// value always has the sign of the exact determinant, its magnitude is approximate.
+// Inputs must be finite and the products must not overflow or underflow.
+
+static constexpr double kEpsilon = std::numeric_limits<double>::epsilon() / 2;
+static constexpr double kOrientationBound = (3 + 16 * kEpsilon) * kEpsilon;
+static constexpr double kOrientationBoundB = (2 + 12 * kEpsilon) * kEpsilon;
+static constexpr double kOrientationBoundC = (9 + 64 * kEpsilon) * kEpsilon * kEpsilon;
+static constexpr double kResultBound = (3 + 8 * kEpsilon) * kEpsilon;
+static constexpr double kInCircleBound = (10 + 96 * kEpsilon) * kEpsilon;
+
+// x + y == a + b exactly, x being the rounded sum; the fast form requires |a| >= |b|.
+inline void fastTwoSum(double a, double b, double& x, double& y){
+    x = a + b;
+    y = b - (x - a);
+}
+
+inline void twoSum(double a, double b, double& x, double& y){
+    x = a + b;
+    double bVirtual = x - a;
+    double aVirtual = x - bVirtual;
+    y = (a - aVirtual) + (b - bVirtual);
+}
+
+inline void twoDiff(double a, double b, double& x, double& y){
+    twoSum(a, -b, x, y);
+}
+
+// x + y == a * b exactly, x being the rounded product.
+inline void twoProduct(double a, double b, double& x, double& y){
+    x = a * b;
+#ifdef __FMA__
+    y = std::fma(a, b, -x);
+#else
+    // Dekker's split of each factor into two 26-bit halves whose products are exact.
+    static constexpr double kSplitter = 134217729.0;
+    auto split = [](double value, double& high, double& low){
+        double c = kSplitter * value;
+        high = c - (c - value);
+        low = value - high;
+    };
+    double aHigh, aLow, bHigh, bLow;
+    split(a, aHigh, aLow);
+    split(b, bHigh, bLow);
+    y = aLow * bLow - (((x - aHigh * bHigh) - aLow * bHigh) - aHigh * bLow);
+#endif
+}
+
+// h = a * b - c * d as a four-component expansion.
+inline void productDifference(double a, double b, double c, double d, double* h){
+    double ab, abTail, cd, cdTail;
+    twoProduct(a, b, ab, abTail);
+    twoProduct(c, d, cd, cdTail);
+    double low, high, middle;
+    twoDiff(abTail, cdTail, low, h[0]);
+    twoSum(ab, low, high, middle);
+    twoDiff(middle, cd, low, h[1]);
+    twoSum(high, low, h[3], h[2]);
+}
+
+// h = e + f with zero components dropped; returns the length of h, at most eLength + fLength.
+inline size_t sumExpansions(const double* e, size_t eLength, const double* f, size_t fLength, double* h){
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+    auto takeE = [&](){ return j == fLength || (i < eLength && (f[j] > e[i]) == (f[j] > -e[i])); };
+    double q = takeE() ? e[i++] : f[j++];
+    while(i < eLength || j < fLength){
+        double tail;
+        twoSum(q, takeE() ? e[i++] : f[j++], q, tail);
+        if(tail != 0) h[k++] = tail;
+    }
+    if(q != 0 || k == 0) h[k++] = q;
+    return k;
+}
+
+// h = e * b with zero components dropped; returns the length of h, at most 2 * eLength.
+inline size_t scaleExpansion(const double* e, size_t eLength, double b, double* h){
+    size_t k = 0;
+    double q, tail;
+    twoProduct(e[0], b, q, tail);
+    if(tail != 0) h[k++] = tail;
+    for(size_t i = 1; i < eLength; ++i){
+        double product, productTail, sum;
+        twoProduct(e[i], b, product, productTail);
+        twoSum(q, productTail, sum, tail);
+        if(tail != 0) h[k++] = tail;
+        fastTwoSum(product, sum, q, tail);
+        if(tail != 0) h[k++] = tail;
+    }
+    if(q != 0 || k == 0) h[k++] = q;
+    return k;
+}
+
+// The refining stages are kept out of line and declared const, so that a filter inlined into
+// a hot loop neither grows it nor makes the compiler assume that memory changed after a call.
+// Each stage tightens the previous one: the products of the rounded differences exactly, then
+// a first-order correction for the rounding of the differences, then everything exactly.
+__attribute__((noinline, const)) inline double orient2dAdaptive(double ax, double ay, double bx, double by, double cx, double cy, double detSum){
+    double acx = ax - cx;
+    double bcx = bx - cx;
+    double acy = ay - cy;
+    double bcy = by - cy;
+
+    double b[4];
+    productDifference(acx, bcy, acy, bcx, b);
+    double det = b[0] + b[1] + b[2] + b[3];
+    double bound = kOrientationBoundB * detSum;
+    if(det >= bound || -det >= bound) return det;
+
+    double acxTail, bcxTail, acyTail, bcyTail, rounded;
+    twoDiff(ax, cx, rounded, acxTail);
+    twoDiff(bx, cx, rounded, bcxTail);
+    twoDiff(ay, cy, rounded, acyTail);
+    twoDiff(by, cy, rounded, bcyTail);
+    if(acxTail == 0 && acyTail == 0 && bcxTail == 0 && bcyTail == 0) return det;
+
+    bound = kOrientationBoundC * detSum + kResultBound * std::fabs(det);
+    det += (acx * bcyTail + bcy * acxTail) - (acy * bcxTail + bcx * acyTail);
+    if(det >= bound || -det >= bound) return det;
+
+    double u[4], c1[8], c2[12], d[16];
+    productDifference(acxTail, bcy, acyTail, bcx, u);
+    size_t c1Length = sumExpansions(b, 4, u, 4, c1);
+    productDifference(acx, bcyTail, acy, bcxTail, u);
+    size_t c2Length = sumExpansions(c1, c1Length, u, 4, c2);
+    productDifference(acxTail, bcyTail, acyTail, bcxTail, u);
+    size_t dLength = sumExpansions(c2, c2Length, u, 4, d);
+    return d[dLength - 1];
+}
+
+// Positive when a, b, c turn counter-clockwise, negative when clockwise, zero when collinear;
+// approximately twice the signed area of the triangle.
+inline double orient2d(double ax, double ay, double bx, double by, double cx, double cy){
+    double left = (ax - cx) * (by - cy);
+    double right = (ay - cy) * (bx - cx);
+    double det = left - right;
+    double detSum = std::fabs(left) + std::fabs(right);
+    double bound = kOrientationBound * detSum;
+    if(det > bound || -det > bound || (det == 0 && bound == 0)) return det;
+    return orient2dAdaptive(ax, ay, bx, by, cx, cy, detSum);
+}
+
+// The 4x4 lifted determinant expanded along its lifted column. Every 2x2 minor of the raw
+// coordinates is an exact four-component expansion, so no difference has to be rounded.
+__attribute__((noinline, const)) inline double incircleExact(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy){
+    double ab[4], bc[4], cd[4], da[4], ac[4], bd[4];
+    productDifference(ax, by, bx, ay, ab);
+    productDifference(bx, cy, cx, by, bc);
+    productDifference(cx, dy, dx, cy, cd);
+    productDifference(dx, ay, ax, dy, da);
+    productDifference(ax, cy, cx, ay, ac);
+    productDifference(bx, dy, dx, by, bd);
+
+    double temp[8], cda[12], dab[12], abc[12], bcd[12];
+    size_t cdaLength = sumExpansions(temp, sumExpansions(cd, 4, da, 4, temp), ac, 4, cda);
+    size_t dabLength = sumExpansions(temp, sumExpansions(da, 4, ab, 4, temp), bd, 4, dab);
+    for(size_t i = 0; i < 4; ++i){
+        bd[i] = -bd[i];
+        ac[i] = -ac[i];
+    }
+    size_t abcLength = sumExpansions(temp, sumExpansions(ab, 4, bc, 4, temp), ac, 4, abc);
+    size_t bcdLength = sumExpansions(temp, sumExpansions(bc, 4, cd, 4, temp), bd, 4, bcd);
+
+    // sign * (x^2 + y^2) * minor
+    auto lifted = [](const double* minor, size_t length, double x, double y, double sign, double* h){
+        double x24[24], x48[48], y24[24], y48[48];
+        size_t xLength = scaleExpansion(x24, scaleExpansion(minor, length, x, x24), sign * x, x48);
+        size_t yLength = scaleExpansion(y24, scaleExpansion(minor, length, y, y24), sign * y, y48);
+        return sumExpansions(x48, xLength, y48, yLength, h);
+    };
+    double aDet[96], bDet[96], cDet[96], dDet[96];
+    size_t aLength = lifted(bcd, bcdLength, ax, ay, 1, aDet);
+    size_t bLength = lifted(cda, cdaLength, bx, by, -1, bDet);
+    size_t cLength = lifted(dab, dabLength, cx, cy, 1, cDet);
+    size_t dLength = lifted(abc, abcLength, dx, dy, -1, dDet);
+
+    double abDet[192], cdDet[192], det[384];
+    size_t abLength = sumExpansions(aDet, aLength, bDet, bLength, abDet);
+    size_t cdLength = sumExpansions(cDet, cLength, dDet, dLength, cdDet);
+    return det[sumExpansions(abDet, abLength, cdDet, cdLength, det) - 1];
+}
+
+// Positive when d lies inside the circle through a, b, c, negative outside and zero on it,
+// provided a, b, c are counter-clockwise; the sign flips when they are clockwise.
+inline double incircle(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy){
+    double adx = ax - dx;
+    double ady = ay - dy;
+    double bdx = bx - dx;
+    double bdy = by - dy;
+    double cdx = cx - dx;
+    double cdy = cy - dy;
+
+    double bdxcdy = bdx * cdy;
+    double cdxbdy = cdx * bdy;
+    double alift = adx * adx + ady * ady;
+    double cdxady = cdx * ady;
+    double adxcdy = adx * cdy;
+    double blift = bdx * bdx + bdy * bdy;
+    double adxbdy = adx * bdy;
+    double bdxady = bdx * ady;
+    double clift = cdx * cdx + cdy * cdy;
+
+    double det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+    double permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * alift
+        + (std::fabs(cdxady) + std::fabs(adxcdy)) * blift
+        + (std::fabs(adxbdy) + std::fabs(bdxady)) * clift;
+    double bound = kInCircleBound * permanent;
+    if(det > bound || -det > bound || (det == 0 && bound == 0)) return det;
+    return incircleExact(ax, ay, bx, by, cx, cy, dx, dy);
+}
+
+// a * b - c * d to within a few ulps, where the plain formula can lose every significant bit
+// to cancellation.
+inline double differenceOfProducts(double a, double b, double c, double d){
+    double ab, abTail, cd, cdTail;
+    twoProduct(a, b, ab, abTail);
+    twoProduct(c, d, cd, cdTail);
+    return (ab - cd) + (abTail - cdTail);
+}
@@ -0,0 +1,240 @@
+#pragma once
+#include "geometry.h"
+#include "shape_store.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Binary shape catalog, version 1:
+//   ShapeFileHeader | double scalars[scalarCount] | ShapeRecord records[shapeCount]
+// Every shape owns a run of scalars in the shared pool: vertex coordinates for polygons,
+// center and radius for circles, both focuses and the diameter for ellipses.
+// The record table goes last so that the writer can stream scalars without knowing the
+// total up front; the header counts are patched when the writer is finished.
+// Files are written in host byte order and rejected on a byte order mismatch.
+
+struct ShapeFileHeader{
+    static constexpr char kMagic[4] = {'G', 'S', 'H', 'P'};
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kByteOrder = 0x01020304;
+
+    char magic[4] = {kMagic[0], kMagic[1], kMagic[2], kMagic[3]};
+    uint32_t version = kVersion;
+    uint64_t shapeCount = 0;
+    uint64_t scalarCount = 0;
+    uint32_t byteOrder = kByteOrder;
+    uint32_t reserved = 0;
+};
+
+struct ShapeRecord{
+    ShapeKind kind;
+    uint8_t reserved[3] = {0, 0, 0};
+    uint32_t scalarCount;
+    uint64_t offset;
+};
+
+static_assert(sizeof(ShapeFileHeader) == 32 && sizeof(ShapeRecord) == 16);
+static_assert(std::is_standard_layout_v<Point> && sizeof(Point) == 2 * sizeof(double),
+              "vertex runs are reinterpreted as Point arrays");
+
+class ShapeWriter{
+private:
+    std::ofstream out_;
+    std::vector<ShapeRecord> records_;
+    uint64_t scalars_ = 0;
+    bool finished_ = false;
+
+    void append(ShapeKind kind, const double* scalars, size_t count){
+        if(count > UINT32_MAX) throw std::runtime_error("shape has too many scalars for a shape record");
+        out_.write(reinterpret_cast<const char*>(scalars), static_cast<std::streamsize>(count * sizeof(double)));
+        records_.push_back({kind, {0, 0, 0}, static_cast<uint32_t>(count), scalars_});
+        scalars_ += count;
+    }
+
+    void appendPoints(ShapeKind kind, const std::vector<Point>& points){
+        if(points.size() < 3) throw std::runtime_error("cannot write a polygon with fewer than 3 vertices");
+        append(kind, reinterpret_cast<const double*>(points.data()), 2 * points.size());
+    }
+
+public:
+    explicit ShapeWriter(const std::string& path): out_(path, std::ios::binary | std::ios::trunc){
+        if(!out_) throw std::runtime_error("cannot open " + path);
+        ShapeFileHeader header;
+        out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    ShapeWriter(const ShapeWriter&) = delete;
+    ShapeWriter& operator=(const ShapeWriter&) = delete;
+
+    // Call finish() explicitly to observe write errors; the destructor has to swallow them.
+    ~ShapeWriter(){
+        if(finished_) return;
+        try{
+            finish();
+        } catch(const std::exception&){
+        }
+    }
+
+    // Throws std::runtime_error for a shape the format cannot hold: a polygon with fewer than
+    // 3 vertices or more than 2^31 - 1, or a Shape subclass it does not know.
+    void write(const Shape& shape){
+        if(const Triangle* t = dynamic_cast<const Triangle*>(&shape)){
+            appendPoints(ShapeKind::kTriangle, t->getVertices());
+        } else if(const Square* sq = dynamic_cast<const Square*>(&shape)){
+            appendPoints(ShapeKind::kSquare, sq->getVertices());
+        } else if(const Rectangle* r = dynamic_cast<const Rectangle*>(&shape)){
+            appendPoints(ShapeKind::kRectangle, r->getVertices());
+        } else if(const Circle* c = dynamic_cast<const Circle*>(&shape)){
+            double scalars[3] = {c->center().x, c->center().y, c->radius()};
+            append(ShapeKind::kCircle, scalars, 3);
+        } else if(const Ellipse* e = dynamic_cast<const Ellipse*>(&shape)){
+            std::pair<Point, Point> f = e->focuses();
+            double scalars[5] = {f.first.x, f.first.y, f.second.x, f.second.y, e->diameter()};
+            append(ShapeKind::kEllipse, scalars, 5);
+        } else if(const Polygon* p = dynamic_cast<const Polygon*>(&shape)){
+            appendPoints(ShapeKind::kPolygon, p->getVertices());
+        } else{
+            throw std::runtime_error("unsupported shape type for a shape file");
+        }
+    }
+
+    void finish(){
+        finished_ = true;
+        out_.write(reinterpret_cast<const char*>(records_.data()), static_cast<std::streamsize>(records_.size() * sizeof(ShapeRecord)));
+        ShapeFileHeader header;
+        header.shapeCount = records_.size();
+        header.scalarCount = scalars_;
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out_.close();
+        if(!out_) throw std::runtime_error("failed to write shape file");
+    }
+};
+
+// Maps a catalog read-only; shapes are materialized on demand by index, or all at once
+// into a ShapeStore by copying whole vertex runs.
+class ShapeReader{
+private:
+    const char* data_ = nullptr;
+    size_t bytes_ = 0;
+    ShapeFileHeader header_;
+    const double* scalars_ = nullptr;
+    const ShapeRecord* records_ = nullptr;
+
+    const Point* points(const ShapeRecord& record) const{
+        return reinterpret_cast<const Point*>(scalars_ + record.offset);
+    }
+
+    bool validRecord(const ShapeRecord& record) const{
+        if(record.offset > header_.scalarCount || record.scalarCount > header_.scalarCount - record.offset) return false;
+        switch(record.kind){
+            case ShapeKind::kTriangle: return record.scalarCount == 6;
+            case ShapeKind::kRectangle:
+            case ShapeKind::kSquare: return record.scalarCount == 8;
+            case ShapeKind::kCircle: return record.scalarCount == 3;
+            case ShapeKind::kEllipse: return record.scalarCount == 5;
+            case ShapeKind::kPolygon: return record.scalarCount % 2 == 0 && record.scalarCount >= 6;
+        }
+        return false;
+    }
+
+public:
+    explicit ShapeReader(const std::string& path){
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) throw std::runtime_error("cannot open " + path);
+        struct stat info;
+        if(::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(ShapeFileHeader))){
+            ::close(fd);
+            throw std::runtime_error("not a shape file: " + path);
+        }
+        bytes_ = static_cast<size_t>(info.st_size);
+        void* mapped = ::mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(mapped == MAP_FAILED) throw std::runtime_error("cannot map " + path);
+        data_ = static_cast<const char*>(mapped);
+
+        std::memcpy(&header_, data_, sizeof(header_));
+        // Each count is bounded by the payload before it is multiplied, so the sizes cannot wrap.
+        size_t payload = bytes_ - sizeof(ShapeFileHeader);
+        bool valid = std::memcmp(header_.magic, ShapeFileHeader::kMagic, 4) == 0
+            && header_.version == ShapeFileHeader::kVersion
+            && header_.byteOrder == ShapeFileHeader::kByteOrder
+            && header_.scalarCount <= payload / sizeof(double)
+            && header_.shapeCount <= payload / sizeof(ShapeRecord)
+            && payload == header_.scalarCount * sizeof(double) + header_.shapeCount * sizeof(ShapeRecord);
+        if(!valid){
+            ::munmap(const_cast<char*>(data_), bytes_);
+            throw std::runtime_error("corrupted or incompatible shape file: " + path);
+        }
+        scalars_ = reinterpret_cast<const double*>(data_ + sizeof(ShapeFileHeader));
+        records_ = reinterpret_cast<const ShapeRecord*>(scalars_ + header_.scalarCount);
+
+        for(size_t i = 0; i < size(); ++i){
+            if(!validRecord(records_[i])){
+                ::munmap(const_cast<char*>(data_), bytes_);
+                throw std::runtime_error("corrupted shape record in " + path);
+            }
+        }
+    }
+
+    ShapeReader(const ShapeReader&) = delete;
+    ShapeReader& operator=(const ShapeReader&) = delete;
+
+    ~ShapeReader(){
+        ::munmap(const_cast<char*>(data_), bytes_);
+    }
+
+    size_t size() const{
+        return static_cast<size_t>(header_.shapeCount);
+    }
+
+    ShapeKind kind(size_t index) const{
+        return records_[index].kind;
+    }
+
+    std::unique_ptr<Shape> shape(size_t index) const{
+        const ShapeRecord& record = records_[index];
+        const double* s = scalars_ + record.offset;
+        const Point* p = points(record);
+        switch(record.kind){
+            case ShapeKind::kTriangle:
+                return std::make_unique<Triangle>(p[0], p[1], p[2]);
+            case ShapeKind::kRectangle:
+                return std::make_unique<Rectangle>(std::vector<Point>(p, p + 4));
+            case ShapeKind::kSquare:
+                return std::make_unique<Square>(std::vector<Point>(p, p + 4));
+            case ShapeKind::kCircle:
+                return std::make_unique<Circle>(Point(s[0], s[1]), s[2]);
+            case ShapeKind::kEllipse:
+                return std::make_unique<Ellipse>(Point(s[0], s[1]), Point(s[2], s[3]), s[4]);
+            case ShapeKind::kPolygon:
+                return std::make_unique<Polygon>(std::vector<Point>(p, p + record.scalarCount / 2));
+        }
+        return nullptr;
+    }
+
+    ShapeStore toStore() const{
+        ShapeStore store;
+        for(size_t i = 0; i < size(); ++i){
+            const ShapeRecord& record = records_[i];
+            const double* s = scalars_ + record.offset;
+            const Point* p = points(record);
+            switch(record.kind){
+                case ShapeKind::kTriangle: store.addTriangle(p[0], p[1], p[2]); break;
+                case ShapeKind::kRectangle: store.addRectangle(p[0], p[1], p[2], p[3]); break;
+                case ShapeKind::kSquare: store.addSquare(p[0], p[1], p[2], p[3]); break;
+                case ShapeKind::kCircle: store.addCircle(Point(s[0], s[1]), s[2]); break;
+                case ShapeKind::kEllipse: store.addEllipse(Point(s[0], s[1]), Point(s[2], s[3]), s[4]); break;
+                case ShapeKind::kPolygon: store.addPolygon(p, record.scalarCount / 2); break;
+            }
+        }
+        return store;
+    }
+};
@@ -0,0 +1,283 @@
+#pragma once
+#include "geometry.h"
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+enum class ShapeKind: uint8_t{
+    kTriangle,
+    kRectangle,
+    kSquare,
+    kCircle,
+    kEllipse,
+    kPolygon
+};
+
+// Devirtualized container: every concrete shape type lives in its own contiguous array,
+// so batch metrics run as plain per-type loops instead of virtual calls over scattered objects.
+// Results of batch queries are returned in insertion order.
+class ShapeStore{
+private:
+    static constexpr size_t kKinds = 6;
+
+    struct Entry{
+        ShapeKind kind;
+        size_t index;
+    };
+
+    std::vector<Entry> entries_;
+    std::vector<size_t> slots_[kKinds];
+
+    std::vector<Point> triangles_;
+    std::vector<Point> rectangles_;
+    std::vector<Point> squares_;
+
+    std::vector<Point> circleCenters_;
+    std::vector<double> circleRadii_;
+
+    std::vector<Point> ellipseFocuses_;
+    std::vector<double> ellipseDiameters_;
+
+    std::vector<Point> polygonVertices_;
+    std::vector<size_t> polygonOffsets_{0};
+
+    void append(ShapeKind kind){
+        std::vector<size_t>& slots = slots_[static_cast<size_t>(kind)];
+        entries_.push_back({kind, slots.size()});
+        slots.push_back(entries_.size() - 1);
+    }
+
+    static double rectanglePerimeter(const Point* v){
+        return 2 * ((v[0] - v[1]).length() + (v[1] - v[2]).length());
+    }
+
+    static double rectangleArea(const Point* v){
+        return (v[0] - v[1]).length() * (v[1] - v[2]).length();
+    }
+
+    static double ellipseMinorAxis(const Point* f, double diameter){
+        return std::sqrt(diameter * diameter - (f[0] - f[1]).length2()) / 2;
+    }
+
+    // Applies a metric to every fixed-size vertex group of one kind and scatters it by insertion slot.
+    template <typename Metric, typename Result>
+    void forEach(ShapeKind kind, const std::vector<Point>& pool, size_t stride, Metric metric, std::vector<Result>& result) const{
+        const std::vector<size_t>& slots = slots_[static_cast<size_t>(kind)];
+        for(size_t i = 0; i < slots.size(); ++i){
+            result[slots[i]] = static_cast<Result>(metric(pool.data() + stride * i));
+        }
+    }
+
+public:
+    ShapeStore() = default;
+
+    ShapeStore(const std::vector<const Shape*>& shapes){
+        for(const Shape* shape : shapes) add(*shape);
+    }
+
+    size_t size() const{
+        return entries_.size();
+    }
+
+    bool empty() const{
+        return entries_.empty();
+    }
+
+    ShapeKind kind(size_t index) const{
+        return entries_[index].kind;
+    }
+
+    void clear(){
+        entries_.clear();
+        for(std::vector<size_t>& slots : slots_) slots.clear();
+        triangles_.clear();
+        rectangles_.clear();
+        squares_.clear();
+        circleCenters_.clear();
+        circleRadii_.clear();
+        ellipseFocuses_.clear();
+        ellipseDiameters_.clear();
+        polygonVertices_.clear();
+        polygonOffsets_.assign(1, 0);
+    }
+
+    void addTriangle(const Point& a, const Point& b, const Point& c){
+        triangles_.insert(triangles_.end(), {a, b, c});
+        append(ShapeKind::kTriangle);
+    }
+
+    void addRectangle(const Point& a, const Point& b, const Point& c, const Point& d){
+        rectangles_.insert(rectangles_.end(), {a, b, c, d});
+        append(ShapeKind::kRectangle);
+    }
+
+    void addSquare(const Point& a, const Point& b, const Point& c, const Point& d){
+        squares_.insert(squares_.end(), {a, b, c, d});
+        append(ShapeKind::kSquare);
+    }
+
+    void addCircle(const Point& center, double radius){
+        circleCenters_.push_back(center);
+        circleRadii_.push_back(radius);
+        append(ShapeKind::kCircle);
+    }
+
+    void addEllipse(const Point& focus1, const Point& focus2, double diameter){
+        ellipseFocuses_.insert(ellipseFocuses_.end(), {focus1, focus2});
+        ellipseDiameters_.push_back(diameter);
+        append(ShapeKind::kEllipse);
+    }
+
+    void addPolygon(const Point* vertices, size_t n){
+        polygonVertices_.insert(polygonVertices_.end(), vertices, vertices + n);
+        polygonOffsets_.push_back(polygonVertices_.size());
+        append(ShapeKind::kPolygon);
+    }
+
+    // Most derived types are checked first: Square before Rectangle, Circle before Ellipse.
+    // Throws std::invalid_argument for a Shape subclass the store has no array for.
+    void add(const Shape& shape){
+        if(const Triangle* t = dynamic_cast<const Triangle*>(&shape)){
+            std::vector<Point> v = t->getVertices();
+            addTriangle(v[0], v[1], v[2]);
+        } else if(const Square* sq = dynamic_cast<const Square*>(&shape)){
+            std::vector<Point> v = sq->getVertices();
+            addSquare(v[0], v[1], v[2], v[3]);
+        } else if(const Rectangle* r = dynamic_cast<const Rectangle*>(&shape)){
+            std::vector<Point> v = r->getVertices();
+            addRectangle(v[0], v[1], v[2], v[3]);
+        } else if(const Circle* c = dynamic_cast<const Circle*>(&shape)){
+            addCircle(c->center(), c->radius());
+        } else if(const Ellipse* e = dynamic_cast<const Ellipse*>(&shape)){
+            std::pair<Point, Point> f = e->focuses();
+            addEllipse(f.first, f.second, e->diameter());
+        } else if(const Polygon* p = dynamic_cast<const Polygon*>(&shape)){
+            std::vector<Point> v = p->getVertices();
+            addPolygon(v.data(), v.size());
+        } else{
+            throw std::invalid_argument("ShapeStore cannot hold this Shape subclass");
+        }
+    }
+
+    std::unique_ptr<Shape> shape(size_t index) const{
+        Entry entry = entries_[index];
+        size_t i = entry.index;
+        switch(entry.kind){
+            case ShapeKind::kTriangle:
+                return std::make_unique<Triangle>(triangles_[3 * i], triangles_[3 * i + 1], triangles_[3 * i + 2]);
+            case ShapeKind::kRectangle:
+                return std::make_unique<Rectangle>(std::vector<Point>(rectangles_.begin() + static_cast<std::ptrdiff_t>(4 * i),
+                                                                      rectangles_.begin() + static_cast<std::ptrdiff_t>(4 * i + 4)));
+            case ShapeKind::kSquare:
+                return std::make_unique<Square>(std::vector<Point>(squares_.begin() + static_cast<std::ptrdiff_t>(4 * i),
+                                                                   squares_.begin() + static_cast<std::ptrdiff_t>(4 * i + 4)));
+            case ShapeKind::kCircle:
+                return std::make_unique<Circle>(circleCenters_[i], circleRadii_[i]);
+            case ShapeKind::kEllipse:
+                return std::make_unique<Ellipse>(ellipseFocuses_[2 * i], ellipseFocuses_[2 * i + 1], ellipseDiameters_[i]);
+            case ShapeKind::kPolygon:
+                return std::make_unique<Polygon>(std::vector<Point>(polygonVertices_.begin() + static_cast<std::ptrdiff_t>(polygonOffsets_[i]),
+                                                                    polygonVertices_.begin() + static_cast<std::ptrdiff_t>(polygonOffsets_[i + 1])));
+        }
+        return nullptr;
+    }
+
+    std::vector<std::unique_ptr<Shape>> toShapes() const{
+        std::vector<std::unique_ptr<Shape>> result;
+        result.reserve(size());
+        for(size_t i = 0; i < size(); ++i) result.push_back(shape(i));
+        return result;
+    }
+
+    // Triangle area is taken from the cross product, Triangle::area uses Heron's formula. They
+    // agree to a few ulps of the area for well-shaped triangles, but Heron's formula loses
+    // relative precision as a triangle flattens, so on needle-like triangles only the cross
+    // product here stays accurate.
+    std::vector<double> areas() const{
+        std::vector<double> result(size());
+
+        forEach(ShapeKind::kTriangle, triangles_, 3, [](const Point* v){
+            return std::fabs((v[1] - v[0]).crossProduct(v[2] - v[0])) / 2;
+        }, result);
+        forEach(ShapeKind::kRectangle, rectangles_, 4, rectangleArea, result);
+        forEach(ShapeKind::kSquare, squares_, 4, rectangleArea, result);
+
+        const std::vector<size_t>& circleSlots = slots_[static_cast<size_t>(ShapeKind::kCircle)];
+        for(size_t i = 0; i < circleSlots.size(); ++i){
+            result[circleSlots[i]] = M_PI * circleRadii_[i] * circleRadii_[i];
+        }
+
+        const std::vector<size_t>& ellipseSlots = slots_[static_cast<size_t>(ShapeKind::kEllipse)];
+        for(size_t i = 0; i < ellipseSlots.size(); ++i){
+            double d = ellipseDiameters_[i];
+            result[ellipseSlots[i]] = M_PI * (d / 2) * ellipseMinorAxis(ellipseFocuses_.data() + 2 * i, d);
+        }
+
+        const std::vector<size_t>& polygonSlots = slots_[static_cast<size_t>(ShapeKind::kPolygon)];
+        for(size_t i = 0; i < polygonSlots.size(); ++i){
+            size_t begin = polygonOffsets_[i];
+            result[polygonSlots[i]] = Polygon::areaOf(polygonVertices_.data() + begin, polygonOffsets_[i + 1] - begin);
+        }
+
+        return result;
+    }
+
+    std::vector<double> perimeters() const{
+        std::vector<double> result(size());
+
+        forEach(ShapeKind::kTriangle, triangles_, 3, [](const Point* v){
+            return (v[0] - v[1]).length() + (v[1] - v[2]).length() + (v[2] - v[0]).length();
+        }, result);
+        forEach(ShapeKind::kRectangle, rectangles_, 4, rectanglePerimeter, result);
+        forEach(ShapeKind::kSquare, squares_, 4, rectanglePerimeter, result);
+
+        const std::vector<size_t>& circleSlots = slots_[static_cast<size_t>(ShapeKind::kCircle)];
+        for(size_t i = 0; i < circleSlots.size(); ++i){
+            result[circleSlots[i]] = 2 * M_PI * circleRadii_[i];
+        }
+
+        const std::vector<size_t>& ellipseSlots = slots_[static_cast<size_t>(ShapeKind::kEllipse)];
+        for(size_t i = 0; i < ellipseSlots.size(); ++i){
+            double a = ellipseDiameters_[i] / 2;
+            double b = ellipseMinorAxis(ellipseFocuses_.data() + 2 * i, ellipseDiameters_[i]);
+            result[ellipseSlots[i]] = M_PI * (3 * (a + b) - std::sqrt((3 * a + b) * (a + 3 * b)));
+        }
+
+        const std::vector<size_t>& polygonSlots = slots_[static_cast<size_t>(ShapeKind::kPolygon)];
+        for(size_t i = 0; i < polygonSlots.size(); ++i){
+            size_t begin = polygonOffsets_[i];
+            result[polygonSlots[i]] = Polygon::perimeterOf(polygonVertices_.data() + begin, polygonOffsets_[i + 1] - begin);
+        }
+
+        return result;
+    }
+
+    std::vector<uint8_t> contains(const Point& point) const{
+        std::vector<uint8_t> result(size());
+
+        auto inTriangle = [&](const Point* v){ return Polygon::containsPointOf(v, 3, point); };
+        auto inQuadrangle = [&](const Point* v){ return Polygon::containsPointOf(v, 4, point); };
+        forEach(ShapeKind::kTriangle, triangles_, 3, inTriangle, result);
+        forEach(ShapeKind::kRectangle, rectangles_, 4, inQuadrangle, result);
+        forEach(ShapeKind::kSquare, squares_, 4, inQuadrangle, result);
+
+        const std::vector<size_t>& circleSlots = slots_[static_cast<size_t>(ShapeKind::kCircle)];
+        for(size_t i = 0; i < circleSlots.size(); ++i){
+            result[circleSlots[i]] = 2 * (circleCenters_[i] - point).length() < 2 * circleRadii_[i] + kAccuracy;
+        }
+
+        const std::vector<size_t>& ellipseSlots = slots_[static_cast<size_t>(ShapeKind::kEllipse)];
+        for(size_t i = 0; i < ellipseSlots.size(); ++i){
+            const Point* f = ellipseFocuses_.data() + 2 * i;
+            result[ellipseSlots[i]] = (f[0] - point).length() + (f[1] - point).length() < ellipseDiameters_[i] + kAccuracy;
+        }
+
+        const std::vector<size_t>& polygonSlots = slots_[static_cast<size_t>(ShapeKind::kPolygon)];
+        for(size_t i = 0; i < polygonSlots.size(); ++i){
+            size_t begin = polygonOffsets_[i];
+            result[polygonSlots[i]] = Polygon::containsPointOf(polygonVertices_.data() + begin, polygonOffsets_[i + 1] - begin, point);
+        }
+
+        return result;
+    }
+};
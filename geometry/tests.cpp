@@ -0,0 +1,624 @@
+#include <gtest/gtest.h>
+#include "clipping.h"
+#include "congruence.h"
+#include "mesh.h"
+#include "shape_io.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+static double totalSignedArea(const std::vector<Polygon>& polygons){
+    double result = 0;
+    for(const Polygon& polygon : polygons) result += signedArea(polygon.getVertices());
+    return result;
+}
+
+static Polygon randomConvex(std::mt19937_64& rng, Point center, double radius, size_t n){
+    std::uniform_real_distribution<double> angle(0, 2 * M_PI);
+    std::vector<double> angles(n);
+    for(double& a : angles) a = angle(rng);
+    std::sort(angles.begin(), angles.end());
+    std::vector<Point> vertices;
+    for(double a : angles) vertices.push_back(center + Point(std::cos(a), std::sin(a)) * radius);
+    return Polygon(vertices);
+}
+
+// A Shape subclass none of the containers know about.
+struct UnknownShape final: Shape{
+    double perimeter() const override{ return 0; }
+    double area() const override{ return 0; }
+    bool operator==(const Shape&) const override{ return false; }
+    bool isCongruentTo(const Shape&) const override{ return false; }
+    bool isSimilarTo(const Shape&) const override{ return false; }
+    bool containsPoint(const Point&) const override{ return false; }
+    void rotate(const Point&, double) override{}
+    void reflect(const Point&) override{}
+    void reflect(const Line&) override{}
+    void scale(const Point&, double) override{}
+    ShapeSignature signature(bool) const override{ return ShapeSignature(); }
+};
+
+// Path of a fresh file in the temporary directory, removed when the test ends.
+struct TemporaryPath{
+    std::string path;
+
+    TemporaryPath(){
+        char name[] = "/tmp/geometry_test_XXXXXX";
+        int fd = ::mkstemp(name);
+        if(fd >= 0) ::close(fd);
+        path = name;
+    }
+
+    ~TemporaryPath(){
+        std::remove(path.c_str());
+    }
+};
+
+static std::vector<std::unique_ptr<Shape>> sampleShapes(){
+    std::vector<std::unique_ptr<Shape>> shapes;
+    shapes.push_back(std::make_unique<Triangle>(Point(0, 0), Point(4, 0), Point(1, 3)));
+    shapes.push_back(std::make_unique<Rectangle>(Point(0, 0), Point(3, 4), 2.0));
+    shapes.push_back(std::make_unique<Square>(Point(1, 1), Point(2, 3)));
+    shapes.push_back(std::make_unique<Circle>(Point(-1, 2), 1.5));
+    shapes.push_back(std::make_unique<Ellipse>(Point(0, 0), Point(2, 1), 5.0));
+    shapes.push_back(std::make_unique<Polygon>(Point(0, 0), Point(2, -1), Point(3, 1), Point(1, 2), Point(-1, 1)));
+    return shapes;
+}
+
+static std::string readFile(const std::string& path){
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const std::string& path, const std::string& bytes){
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// ---------- Выпуклая оболочка, пересечение, сумма Минковского ----------
+TEST(ClippingTest, HullOfSquareWithInnerPoints) {
+    std::vector<Point> points = {{0, 0}, {2, 0}, {2, 2}, {0, 2}, {1, 1}, {0.5, 1.5}, {1, 0}};
+    Polygon hull = convexHull(points);
+    EXPECT_EQ(hull.verticesCount(), 4u);
+    EXPECT_NEAR(signedArea(hull.getVertices()), 4, 1e-12);
+    for(const Point& p : points) EXPECT_TRUE(hull.containsPoint(p));
+}
+
+TEST(ClippingTest, ConvexIntersectionOfSquares) {
+    Polygon a(Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2));
+    Polygon b(Point(1, 1), Point(3, 1), Point(3, 3), Point(1, 3));
+    EXPECT_NEAR(convexIntersection(a, b).area(), 1, 1e-12);
+    EXPECT_NEAR(sutherlandHodgman(a, b).area(), 1, 1e-12);
+}
+
+TEST(ClippingTest, MinkowskiSumAreas) {
+    // Square [0,1]^2 plus the triangle (0,0), (1,0), (0,1): area 1 + 1/2 + mixed term 2.
+    Polygon square(Point(0, 0), Point(1, 0), Point(1, 1), Point(0, 1));
+    Polygon triangle(Point(0, 0), Point(1, 0), Point(0, 1));
+    Polygon sum = minkowskiSum(square, triangle);
+    EXPECT_NEAR(sum.area(), 3.5, 1e-12);
+    EXPECT_GT(signedArea(sum.getVertices()), 0);
+    EXPECT_TRUE(sum.containsPoint(Point(2, 0)));
+    EXPECT_FALSE(sum.containsPoint(Point(2, 1.01)));
+}
+
+// ---------- Булевы операции ----------
+TEST(ClippingTest, UnionKeepsHole) {
+    // A U-shaped outline closed by a bar across its arms leaves the unit square (1,2)^2 open.
+    Polygon u(Point(0, 0), Point(3, 0), Point(3, 3), Point(2, 3), Point(2, 1), Point(1, 1), Point(1, 3), Point(0, 3));
+    Polygon bar(Point(-0.5, 2), Point(3.5, 2), Point(3.5, 2.5), Point(-0.5, 2.5));
+    std::vector<Polygon> united = clip(u, bar, ClipOperation::Union);
+    ASSERT_EQ(united.size(), 2u);
+    EXPECT_GT(signedArea(united[0].getVertices()), 0);
+    EXPECT_NEAR(signedArea(united[1].getVertices()), -1, 1e-12);
+    EXPECT_FALSE(united[1].containsPoint(Point(0.5, 0.5)));
+    EXPECT_TRUE(united[1].containsPoint(Point(1.5, 1.5)));
+
+    double intersection = totalSignedArea(clip(u, bar, ClipOperation::Intersection));
+    EXPECT_NEAR(intersection, 1, 1e-12);
+    EXPECT_NEAR(totalSignedArea(united), u.area() + bar.area() - intersection, 1e-12);
+}
+
+TEST(ClippingTest, InclusionExclusion) {
+    std::mt19937_64 rng(29);
+    std::uniform_real_distribution<double> offset(-1, 1);
+    for(int round = 0; round < 200; ++round){
+        Polygon a = randomConvex(rng, Point(0, 0), 1, 3 + rng() % 8);
+        Polygon b = randomConvex(rng, Point(offset(rng), offset(rng)), 1, 3 + rng() % 8);
+        double intersection = totalSignedArea(clip(a, b, ClipOperation::Intersection));
+        EXPECT_NEAR(intersection, convexIntersection(a, b).area(), 1e-9);
+        EXPECT_NEAR(totalSignedArea(clip(a, b, ClipOperation::Union)), a.area() + b.area() - intersection, 1e-9);
+        EXPECT_NEAR(totalSignedArea(clip(a, b, ClipOperation::Difference)), a.area() - intersection, 1e-9);
+    }
+}
+
+// ---------- Файлы фигур ----------
+TEST(ShapeIoTest, RoundTrip) {
+    TemporaryPath file;
+    std::vector<std::unique_ptr<Shape>> shapes = sampleShapes();
+    {
+        ShapeWriter writer(file.path);
+        for(const std::unique_ptr<Shape>& shape : shapes) writer.write(*shape);
+        writer.finish();
+    }
+    ShapeReader reader(file.path);
+    ASSERT_EQ(reader.size(), shapes.size());
+    ShapeStore store = reader.toStore();
+    std::vector<double> areas = store.areas();
+    for(size_t i = 0; i < shapes.size(); ++i){
+        std::unique_ptr<Shape> loaded = reader.shape(i);
+        EXPECT_TRUE(*loaded == *shapes[i]) << "shape " << i;
+        EXPECT_EQ(typeid(*loaded), typeid(*shapes[i])) << "shape " << i;
+        EXPECT_NEAR(areas[i], shapes[i]->area(), 1e-9) << "shape " << i;
+    }
+}
+
+TEST(ShapeIoTest, WriterRejectsUnrepresentableShapes) {
+    TemporaryPath file;
+    ShapeWriter writer(file.path);
+    EXPECT_THROW(writer.write(UnknownShape()), std::runtime_error);
+    EXPECT_THROW(writer.write(Polygon(Point(0, 0), Point(1, 1))), std::runtime_error);
+    writer.write(Triangle(Point(0, 0), Point(1, 0), Point(0, 1)));
+    writer.finish();
+    EXPECT_EQ(ShapeReader(file.path).size(), 1u);
+}
+
+TEST(ShapeIoTest, RejectsTruncatedAndCorruptFiles) {
+    TemporaryPath file;
+    {
+        ShapeWriter writer(file.path);
+        for(const std::unique_ptr<Shape>& shape : sampleShapes()) writer.write(*shape);
+    }
+    std::string bytes = readFile(file.path);
+    ASSERT_NO_THROW(ShapeReader reader(file.path));
+
+    for(size_t size : {size_t(0), sizeof(ShapeFileHeader) - 1, sizeof(ShapeFileHeader), bytes.size() - 1}){
+        writeFile(file.path, bytes.substr(0, size));
+        EXPECT_THROW(ShapeReader reader(file.path), std::runtime_error) << "size " << size;
+    }
+
+    // Counts whose byte sizes wrap around to the real file size.
+    std::string wrapped = bytes;
+    ShapeFileHeader header;
+    std::memcpy(&header, wrapped.data(), sizeof(header));
+    header.scalarCount += uint64_t(1) << 61;
+    std::memcpy(wrapped.data(), &header, sizeof(header));
+    writeFile(file.path, wrapped);
+    EXPECT_THROW(ShapeReader reader(file.path), std::runtime_error);
+
+    // A record pointing past the scalar pool, and one of an unknown kind.
+    for(size_t field : {offsetof(ShapeRecord, offset), offsetof(ShapeRecord, kind)}){
+        std::string corrupt = bytes;
+        corrupt[bytes.size() - sizeof(ShapeRecord) + field] = '\x7f';
+        writeFile(file.path, corrupt);
+        EXPECT_THROW(ShapeReader reader(file.path), std::runtime_error);
+    }
+}
+
+// ---------- ShapeStore ----------
+TEST(ShapeStoreTest, MetricsMatchVirtualMethods) {
+    std::mt19937_64 rng(26);
+    std::uniform_real_distribution<double> coordinate(-5, 5);
+    auto point = [&](){ return Point(coordinate(rng), coordinate(rng)); };
+    std::vector<std::unique_ptr<Shape>> shapes = sampleShapes();
+    for(int round = 0; round < 50; ++round){
+        shapes.push_back(std::make_unique<Triangle>(point(), point(), point()));
+        shapes.push_back(std::make_unique<Rectangle>(point(), point(), 0.5 + std::fabs(coordinate(rng))));
+        shapes.push_back(std::make_unique<Square>(point(), point()));
+        shapes.push_back(std::make_unique<Circle>(point(), 0.1 + std::fabs(coordinate(rng))));
+        Point f1 = point();
+        Point f2 = point();
+        shapes.push_back(std::make_unique<Ellipse>(f1, f2, (f1 - f2).length() + 0.1 + std::fabs(coordinate(rng))));
+        shapes.push_back(std::make_unique<Polygon>(randomConvex(rng, point(), 3, 3 + rng() % 6)));
+    }
+    std::vector<const Shape*> pointers;
+    for(const std::unique_ptr<Shape>& shape : shapes) pointers.push_back(shape.get());
+    ShapeStore store(pointers);
+    ASSERT_EQ(store.size(), shapes.size());
+
+    std::vector<double> areas = store.areas();
+    std::vector<double> perimeters = store.perimeters();
+    for(size_t i = 0; i < shapes.size(); ++i){
+        EXPECT_NEAR(areas[i], shapes[i]->area(), 1e-9 * (1 + areas[i])) << "shape " << i;
+        EXPECT_NEAR(perimeters[i], shapes[i]->perimeter(), 1e-9 * (1 + perimeters[i])) << "shape " << i;
+    }
+    for(int probe = 0; probe < 20; ++probe){
+        Point p = point();
+        std::vector<uint8_t> inside = store.contains(p);
+        for(size_t i = 0; i < shapes.size(); ++i){
+            EXPECT_EQ(inside[i] != 0, shapes[i]->containsPoint(p)) << "shape " << i << " probe " << probe;
+        }
+    }
+}
+
+TEST(ShapeStoreTest, RejectsUnknownShapes) {
+    ShapeStore store;
+    EXPECT_THROW(store.add(UnknownShape()), std::invalid_argument);
+    EXPECT_TRUE(store.empty());
+}
+
+// ---------- Группировка конгруэнтных и подобных фигур ----------
+static std::vector<std::vector<size_t>> groupPairwise(const std::vector<const Shape*>& shapes, bool similar){
+    std::vector<std::vector<size_t>> groups;
+    for(size_t i = 0; i < shapes.size(); ++i){
+        bool placed = false;
+        for(std::vector<size_t>& group : groups){
+            const Shape& representative = *shapes[group.front()];
+            if(similar ? shapes[i]->isSimilarTo(representative) : shapes[i]->isCongruentTo(representative)){
+                group.push_back(i);
+                placed = true;
+                break;
+            }
+        }
+        if(!placed) groups.push_back({i});
+    }
+    return groups;
+}
+
+TEST(CongruenceTest, MatchesPairwiseGrouping) {
+    std::mt19937_64 rng(27);
+    std::uniform_real_distribution<double> unit(-1, 1);
+    std::vector<std::unique_ptr<Shape>> shapes;
+    for(int base = 0; base < 40; ++base){
+        Polygon polygon = randomConvex(rng, Point(0, 0), 1 + unit(rng) / 2, 3 + rng() % 5);
+        Point focus(unit(rng), unit(rng));
+        double diameter = 3 + unit(rng);
+        // Each base shape is followed by rotated, reflected and scaled copies of it.
+        for(int copy = 0; copy < 5; ++copy){
+            std::unique_ptr<Shape> pair[2] = {std::make_unique<Polygon>(polygon), std::make_unique<Ellipse>(focus, Point(0, 0) - focus, diameter)};
+            for(std::unique_ptr<Shape>& shape : pair){
+                if(copy > 0) shape->rotate(Point(unit(rng), unit(rng)), M_PI * unit(rng));
+                if(copy % 2 == 1) shape->reflect(Line(Point(0, 0), Point(unit(rng), 1)));
+                if(copy == 4) shape->scale(Point(0, 0), 2.5);
+                shapes.push_back(std::move(shape));
+            }
+        }
+    }
+    // Congruent squares whose sides fall on either side of a bucket edge.
+    double width = Polygon(Point(0, 0), Point(1, 0), Point(1, 1), Point(0, 1)).signature(false).bucketWidth(2);
+    for(double side : {250 * width - 2.5e-11, 250 * width + 2.5e-11}){
+        shapes.push_back(std::make_unique<Polygon>(Point(0, 0), Point(side, 0), Point(side, side), Point(0, side)));
+    }
+    // Squared focal distances far beyond the range of a 64-bit bucket index.
+    shapes.push_back(std::make_unique<Ellipse>(Point(0, 0), Point(1e15, 0), 2e15));
+    shapes.push_back(std::make_unique<Ellipse>(Point(1e15, 0), Point(2e15, 0), 2e15));
+
+    std::vector<const Shape*> pointers;
+    for(const std::unique_ptr<Shape>& shape : shapes) pointers.push_back(shape.get());
+    for(bool similar : {false, true}){
+        std::vector<std::vector<size_t>> expected = groupPairwise(pointers, similar);
+        EXPECT_EQ(groupShapes(pointers, similar), expected) << (similar ? "similar" : "congruent");
+        // Per base shape, the scaled copy only joins the others for similarity.
+        EXPECT_EQ(expected.size(), similar ? 82u : 162u);
+    }
+    std::vector<std::vector<size_t>> congruent = groupCongruent(pointers);
+    ASSERT_GE(congruent.size(), 2u);
+    EXPECT_EQ(congruent[congruent.size() - 2], (std::vector<size_t>{shapes.size() - 4, shapes.size() - 3}));
+    EXPECT_EQ(congruent.back(), (std::vector<size_t>{shapes.size() - 2, shapes.size() - 1}));
+}
+
+TEST(CongruenceTest, LargePartitionOnEveryThreadCount) {
+    std::mt19937_64 rng(28);
+    std::uniform_real_distribution<double> unit(-1, 1);
+    auto rectangle = [](double a, double b){
+        return Polygon(Point(0, 0), Point(a, 0), Point(a, b), Point(0, b));
+    };
+    // Rectangles of one perimeter in 200 proportions, then moved copies of the first 30 of them,
+    // scaled when the copy index is a multiple of five: one partition, scanned block by block.
+    std::vector<Polygon> polygons;
+    for(int i = 0; i < 200; ++i) polygons.push_back(rectangle(1 + i * 0.01, 5 - i * 0.01));
+    for(size_t copy = 0; copy < 4500; ++copy){
+        Polygon polygon = polygons[copy % 30];
+        polygon.rotate(Point(unit(rng), unit(rng)), M_PI * unit(rng));
+        if(copy % 2 == 1) polygon.reflect(Line(Point(0, 0), Point(unit(rng), 1)));
+        if(copy % 5 == 0) polygon.scale(Point(0, 0), 1.5);
+        polygons.push_back(polygon);
+    }
+
+    std::vector<const Shape*> pointers;
+    for(const Polygon& polygon : polygons) pointers.push_back(&polygon);
+    for(bool similar : {false, true}){
+        std::vector<std::vector<size_t>> expected = groupPairwise(pointers, similar);
+        EXPECT_EQ(expected.size(), similar ? 200u : 206u);
+        for(size_t threads : {size_t(1), size_t(4)}){
+            EXPECT_EQ(groupShapes(pointers, similar, threads), expected) << similar << " " << threads;
+        }
+    }
+}
+
+// ---------- Кэш производных величин ----------
+TEST(MetricsCacheTest, ConcurrentFirstUse) {
+    const Polygon polygon(Point(0, 0), Point(4, 0), Point(4, 3), Point(0, 3));
+    const Triangle triangle(Point(0, 0), Point(4, 0), Point(0, 3));
+    std::vector<double> results(4 * 5);
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < 4; ++t){
+        threads.emplace_back([&, t](){
+            double* r = results.data() + 5 * t;
+            r[0] = polygon.perimeter();
+            r[1] = polygon.area() + (polygon.isConvex() ? 1 : 0);
+            r[2] = triangle.circumscribedCircle().radius();
+            r[3] = triangle.inscribedCircle().radius();
+            r[4] = triangle.orthocenter().x + triangle.sideLengths()[1];
+        });
+    }
+    for(std::thread& thread : threads) thread.join();
+    for(size_t t = 0; t < 4; ++t){
+        EXPECT_DOUBLE_EQ(results[5 * t], 14);
+        EXPECT_DOUBLE_EQ(results[5 * t + 1], 13);
+        EXPECT_DOUBLE_EQ(results[5 * t + 2], 2.5);
+        EXPECT_DOUBLE_EQ(results[5 * t + 3], 1);
+        EXPECT_DOUBLE_EQ(results[5 * t + 4], 5);
+    }
+}
+
+TEST(MetricsCacheTest, TransformsAndCopies) {
+    Triangle triangle(Point(0, 0), Point(4, 0), Point(0, 3));
+    EXPECT_DOUBLE_EQ(triangle.circumscribedCircle().center().x, 2);
+    Triangle copy = triangle;
+    triangle.scale(Point(0, 0), 2);
+    EXPECT_DOUBLE_EQ(triangle.perimeter(), 24);
+    EXPECT_DOUBLE_EQ(triangle.circumscribedCircle().center().x, 4);
+    EXPECT_DOUBLE_EQ(copy.perimeter(), 12);
+    EXPECT_DOUBLE_EQ(copy.circumscribedCircle().center().x, 2);
+    copy = triangle;
+    EXPECT_DOUBLE_EQ(copy.area(), 24);
+    EXPECT_EQ(copy.boundingBox().second, Point(8, 6));
+}
+
+// ---------- Другие скалярные типы ----------
+TEST(ScalarTypesTest, FloatAndFixedAgreeWithDouble) {
+    Triangle reference(Point(0.5, 0.25), Point(4, 1), Point(1.5, 3));
+    BasicTriangle<float> single(BasicPoint<float>(0.5f, 0.25f), BasicPoint<float>(4, 1), BasicPoint<float>(1.5f, 3));
+    using FixedPoint = BasicPoint<Fixed64>;
+    BasicTriangle<Fixed64> fixed(FixedPoint(Fixed64(0.5), Fixed64(0.25)), FixedPoint(Fixed64(4), Fixed64(1)), FixedPoint(Fixed64(1.5), Fixed64(3)));
+    EXPECT_NEAR(static_cast<double>(single.area()), reference.area(), 1e-5);
+    EXPECT_NEAR(static_cast<double>(fixed.area()), reference.area(), 1e-6);
+    EXPECT_NEAR(static_cast<double>(single.circumscribedCircle().radius()), reference.circumscribedCircle().radius(), 1e-5);
+    EXPECT_NEAR(static_cast<double>(fixed.circumscribedCircle().radius()), reference.circumscribedCircle().radius(), 1e-6);
+    EXPECT_TRUE(fixed.containsPoint(FixedPoint(Fixed64(2), Fixed64(1.5))));
+}
+
+// ---------- Принадлежность точек ----------
+// Star-shaped, generally non-convex polygon around center.
+template <typename T>
+static BasicPolygon<T> randomStar(std::mt19937_64& rng, size_t n){
+    std::uniform_real_distribution<double> radius(0.3, 1.0);
+    std::vector<BasicPoint<T>> vertices;
+    for(size_t i = 0; i < n; ++i){
+        double a = 2 * M_PI * static_cast<double>(i) / static_cast<double>(n);
+        double r = radius(rng);
+        vertices.emplace_back(static_cast<T>(r * std::cos(a)), static_cast<T>(r * std::sin(a)));
+    }
+    return BasicPolygon<T>(vertices);
+}
+
+// Random points with vertices, edge midpoints and points level with vertices mixed in, so that
+// the boundary rule and the crossing parity both get exercised.
+template <typename T>
+static std::vector<BasicPoint<T>> probePoints(std::mt19937_64& rng, const std::vector<BasicPoint<T>>& vertices, size_t count){
+    std::uniform_real_distribution<double> coordinate(-1.1, 1.1);
+    std::uniform_int_distribution<size_t> vertex(0, vertices.size() - 1);
+    std::vector<BasicPoint<T>> points;
+    for(size_t i = 0; i < count; ++i){
+        const BasicPoint<T>& a = vertices[vertex(rng)];
+        const BasicPoint<T>& b = vertices[(vertex(rng) + 1) % vertices.size()];
+        switch(i % 4){
+            case 0: points.push_back(a); break;
+            case 1: points.emplace_back((a.x + b.x) / 2, (a.y + b.y) / 2); break;
+            case 2: points.emplace_back(static_cast<T>(coordinate(rng)), a.y); break;
+            default: points.emplace_back(static_cast<T>(coordinate(rng)), static_cast<T>(coordinate(rng)));
+        }
+    }
+    return points;
+}
+
+template <typename T>
+static void expectBatchMatchesSingle(uint64_t seed){
+    std::mt19937_64 rng(seed);
+    const size_t lanes = BasicPolygon<T>::kContainsLanes;
+    const size_t sizes[] = {3, 5, 17, 64};
+    const size_t counts[] = {1, lanes - 1, lanes + 1, 3 * lanes + 5, 2 * 512 * lanes + 7};
+    for(size_t n : sizes){
+        BasicPolygon<T> polygon = randomStar<T>(rng, n);
+        for(size_t count : counts){
+            std::vector<BasicPoint<T>> points = probePoints(rng, polygon.getVertices(), count);
+            std::vector<uint8_t> out(count, 2);
+            polygon.containsPoints(points, out);
+            for(size_t i = 0; i < count; ++i){
+                ASSERT_EQ(out[i], polygon.containsPoint(points[i]) ? 1 : 0) << "n = " << n << ", count = " << count << ", i = " << i;
+            }
+        }
+    }
+}
+
+TEST(ContainsPointsTest, MatchesContainsPointForDouble) {
+    expectBatchMatchesSingle<double>(7);
+}
+
+TEST(ContainsPointsTest, MatchesContainsPointForFloat) {
+    expectBatchMatchesSingle<float>(11);
+}
+
+TEST(ContainsPointsTest, ThreadCountsAndShortOutput) {
+    std::mt19937_64 rng(19);
+    Polygon polygon = randomStar<double>(rng, 40);
+    std::vector<Point> points = probePoints(rng, polygon.getVertices(), 5 * 512 * Polygon::kContainsLanes + 3);
+    std::vector<uint8_t> expected(points.size());
+    polygon.containsPoints(points, expected, 1);
+    for(size_t threads : {size_t(2), size_t(3), size_t(16)}){
+        std::vector<uint8_t> out(points.size());
+        polygon.containsPoints(points, out, threads);
+        EXPECT_EQ(out, expected) << threads;
+    }
+    std::vector<uint8_t> shorter(points.size() - 1);
+    EXPECT_THROW(polygon.containsPoints(points, shorter), std::invalid_argument);
+}
+
+// ---------- Точные предикаты ----------
+// Reference signs in 128-bit integers for coordinates that are integers once scaled by
+// 2^exponent; the callers keep the magnitudes small enough for the determinants to fit.
+__extension__ typedef __int128 Wide;
+
+static Wide scaled(double value, int exponent){
+    return static_cast<Wide>(std::ldexp(value, exponent));
+}
+
+static int exactOrientation(const Point& a, const Point& b, const Point& c, int exponent){
+    Wide abx = scaled(b.x, exponent) - scaled(a.x, exponent), aby = scaled(b.y, exponent) - scaled(a.y, exponent);
+    Wide acx = scaled(c.x, exponent) - scaled(a.x, exponent), acy = scaled(c.y, exponent) - scaled(a.y, exponent);
+    Wide det = abx * acy - aby * acx;
+    return (det > 0) - (det < 0);
+}
+
+static int exactInCircle(const Point& a, const Point& b, const Point& c, const Point& d, int exponent){
+    Wide dx = scaled(d.x, exponent), dy = scaled(d.y, exponent);
+    Wide adx = scaled(a.x, exponent) - dx, ady = scaled(a.y, exponent) - dy;
+    Wide bdx = scaled(b.x, exponent) - dx, bdy = scaled(b.y, exponent) - dy;
+    Wide cdx = scaled(c.x, exponent) - dx, cdy = scaled(c.y, exponent) - dy;
+    Wide det = (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy)
+        + (bdx * bdx + bdy * bdy) * (cdx * ady - adx * cdy)
+        + (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+    return ((det > 0) - (det < 0)) * exactOrientation(a, b, c, exponent);
+}
+
+TEST(PredicatesTest, OrientationNearTheDiagonal) {
+    // Points within a few ulps of (0.5, 0.5) against the line through (12, 12) and (24, 24):
+    // the naive determinant gets many of these wrong. Scaled by 2^53 everything is an integer
+    // below 2^58, so the exact determinant fits in 128 bits.
+    const Point b(12, 12), c(24, 24);
+    const double ulp = std::ldexp(1.0, -53);
+    size_t collinear = 0;
+    for(int i = 0; i < 64; ++i){
+        for(int j = 0; j < 64; ++j){
+            const Point a(0.5 + i * ulp, 0.5 + j * ulp);
+            int expected = exactOrientation(a, b, c, 53);
+            ASSERT_EQ(orientationSign(a, b, c), expected) << i << ' ' << j;
+            ASSERT_EQ(orientationSign(b, c, a), expected) << i << ' ' << j;
+            ASSERT_EQ(orientationSign(a, c, b), -expected) << i << ' ' << j;
+            collinear += expected == 0;
+        }
+    }
+    EXPECT_EQ(collinear, 64u);
+
+    const Point origin(0, 0), far(1e10, 1e10);
+    EXPECT_EQ(orientationSign(origin, far, Point(1, 1)), 0);
+    EXPECT_EQ(orientationSign(origin, far, Point(1, std::nextafter(1.0, 2.0))), 1);
+    EXPECT_EQ(orientationSign(origin, far, Point(1, std::nextafter(1.0, 0.0))), -1);
+    EXPECT_EQ(orientationSign(BasicPoint<float>(0, 0), BasicPoint<float>(1e6f, 1e6f), BasicPoint<float>(1, std::nextafter(1.0f, 2.0f))), 1);
+}
+
+TEST(PredicatesTest, InCircleNearCocircularPoints) {
+    // Integer points on circles of radius 5k, in units of 2^-20 so that the values are not
+    // integers; nudging the fourth point by one unit makes the sign depend on the last bits.
+    const int triples[][2] = {{3, 4}, {4, -3}, {-5, 0}, {0, 5}, {-3, -4}, {5, 0}, {-4, 3}};
+    std::mt19937_64 rng(5);
+    std::uniform_int_distribution<int> center(-1 << 22, 1 << 22);
+    std::uniform_int_distribution<int> scale(1, 1 << 18);
+    std::uniform_int_distribution<int> nudge(-1, 1);
+    std::uniform_int_distribution<size_t> pick(0, std::size(triples) - 1);
+    auto point = [](long x, long y){ return Point(std::ldexp(static_cast<double>(x), -20), std::ldexp(static_cast<double>(y), -20)); };
+    for(int trial = 0; trial < 2000; ++trial){
+        long cx = center(rng), cy = center(rng), k = scale(rng);
+        Point on[4];
+        for(Point& p : on){
+            const int* t = triples[pick(rng)];
+            p = point(cx + k * t[0], cy + k * t[1]);
+        }
+        const int* t = triples[pick(rng)];
+        const Point d = point(cx + k * t[0] + nudge(rng), cy + k * t[1] + nudge(rng));
+        int expected = exactInCircle(on[0], on[1], on[2], d, 20);
+        ASSERT_EQ(inCircleSign(on[0], on[1], on[2], d), expected) << trial;
+        ASSERT_EQ(inCircleSign(on[1], on[0], on[2], d), expected) << trial;
+        if(orientationSign(on[0], on[1], on[2]) != 0){
+            ASSERT_EQ(inCircleSign(on[0], on[1], on[2], on[3]), 0) << trial;
+        }
+    }
+
+    // One ulp off the circle of radius 5 about the origin.
+    const Point a(3, 4), b(-5, 0), c(4, -3);
+    EXPECT_EQ(inCircleSign(a, b, c, Point(0, 5)), 0);
+    EXPECT_EQ(inCircleSign(a, b, c, Point(0, std::nextafter(5.0, 0.0))), 1);
+    EXPECT_EQ(inCircleSign(a, b, c, Point(0, std::nextafter(5.0, 6.0))), -1);
+    EXPECT_EQ(inCircleSign(c, b, a, Point(0, std::nextafter(5.0, 0.0))), 1);
+}
+
+TEST(PredicatesTest, CircumscribedCircleContains) {
+    for(const Triangle& triangle : {Triangle(Point(3, 4), Point(-5, 0), Point(4, -3)), Triangle(Point(4, -3), Point(-5, 0), Point(3, 4))}){
+        EXPECT_TRUE(triangle.circumscribedCircleContains(Point(0, 0)));
+        EXPECT_TRUE(triangle.circumscribedCircleContains(Point(-3, -4)));
+        EXPECT_TRUE(triangle.circumscribedCircleContains(Point(std::nextafter(5.0, 0.0), 0)));
+        EXPECT_FALSE(triangle.circumscribedCircleContains(Point(std::nextafter(5.0, 6.0), 0)));
+        EXPECT_FALSE(triangle.circumscribedCircleContains(Point(4, 4)));
+    }
+}
+
+// ---------- Метрики сетки ----------
+// Random mesh away from the origin whose triangles have radius ratio at least 0.2, so that
+// their circumcenters are well conditioned; each triangle has its own three vertices.
+template <typename T>
+static BasicTriangleMesh<T> randomMesh(std::mt19937_64& rng, size_t size){
+    std::uniform_real_distribution<double> coordinate(100, 200);
+    std::uniform_real_distribution<double> offset(-3, 3);
+    BasicTriangleMesh<T> mesh;
+    while(mesh.size() < size){
+        double x = coordinate(rng), y = coordinate(rng);
+        BasicPoint<T> corners[3];
+        for(BasicPoint<T>& corner : corners) corner = BasicPoint<T>(static_cast<T>(x + offset(rng)), static_cast<T>(y + offset(rng)));
+        BasicTriangle<double> check(Point(corners[0].x, corners[0].y), Point(corners[1].x, corners[1].y), Point(corners[2].x, corners[2].y));
+        if(2 * check.inscribedCircle().radius() < 0.2 * check.circumscribedCircle().radius()) continue;
+        uint32_t first = static_cast<uint32_t>(mesh.vertices.size());
+        mesh.vertices.insert(mesh.vertices.end(), corners, corners + 3);
+        mesh.triangles.push_back({first, first + 1, first + 2});
+    }
+    return mesh;
+}
+
+template <typename T>
+static void expectMeshMatchesTriangles(uint64_t seed, double tolerance){
+    std::mt19937_64 rng(seed);
+    const size_t lanes = MeshKernel<T>::kLanes;
+    const size_t sizes[] = {1, lanes + 1, 3 * lanes + lanes / 2 + 1, 2 * 1024 * lanes + 3};
+    auto near = [&](T actual, T expected, double scale){
+        return std::abs(static_cast<double>(actual) - static_cast<double>(expected)) <= tolerance * scale;
+    };
+    auto nearPoint = [&](const BasicPoint<T>& actual, const BasicPoint<T>& expected, double scale){
+        return near(actual.x, expected.x, scale) && near(actual.y, expected.y, scale);
+    };
+    BasicMeshMetrics<T> metrics;
+    for(size_t size : sizes){
+        BasicTriangleMesh<T> mesh = randomMesh<T>(rng, size);
+        analyzeMesh(mesh, metrics);
+        ASSERT_EQ(metrics.area.size(), size);
+        for(size_t i = 0; i < size; ++i){
+            BasicTriangle<T> triangle = mesh.triangle(i);
+            BasicCircle<T> circumscribed = triangle.circumscribedCircle();
+            BasicCircle<T> inscribed = triangle.inscribedCircle();
+            double radius = static_cast<double>(circumscribed.radius());
+            // Positions are about 200 from the origin, lengths about the circumradius. The
+            // circumradius of BasicTriangle is the distance to its circumcenter, so it carries
+            // the rounding of a position.
+            double position = 200 + radius;
+            ASSERT_TRUE(near(metrics.area[i], triangle.area(), radius * radius)) << size << ' ' << i;
+            ASSERT_TRUE(near(metrics.circumradius[i], circumscribed.radius(), position)) << size << ' ' << i;
+            ASSERT_TRUE(near(metrics.inradius[i], inscribed.radius(), radius)) << size << ' ' << i;
+            ASSERT_TRUE(near(metrics.quality[i], 2 * inscribed.radius() / circumscribed.radius(), position / radius)) << size << ' ' << i;
+            ASSERT_TRUE(nearPoint(metrics.circumcenter[i], circumscribed.center(), position)) << size << ' ' << i;
+            ASSERT_TRUE(nearPoint(metrics.incenter[i], inscribed.center(), position)) << size << ' ' << i;
+            ASSERT_TRUE(nearPoint(metrics.centroid[i], triangle.centroid(), position)) << size << ' ' << i;
+            ASSERT_TRUE(nearPoint(metrics.orthocenter[i], triangle.orthocenter(), position)) << size << ' ' << i;
+        }
+    }
+}
+
+TEST(MeshTest, MatchesTriangleMethodsForDouble) {
+    expectMeshMatchesTriangles<double>(13, 1e-10);
+}
+
+TEST(MeshTest, MatchesTriangleMethodsForFloat) {
+    expectMeshMatchesTriangles<float>(17, 1e-4);
+}
@@ -0,0 +1,73 @@
+#include "concurrent_stack.h"
+#include "stack.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Usage: bench_concurrent [operations]
+// The threads alternate pushing a short string and popping one, splitting the operations
+// (2 * 10^6 by default) evenly, first on ConcurrentStack and then on the arena Stack of stack.h
+// behind a mutex, for 1, 2, 4, ... 64 threads. Prints operations per second for both. Build with
+//   g++ -std=c++17 -O2 bench_concurrent.cpp -lpthread
+
+// Stack keeps its values in one arena and answers on an Output; here values go in with
+// append/seal and come out of the arena directly, and the Output is never written.
+struct LockedStack {
+    std::mutex mutex;
+    Output out{-1};
+    Stack s{out};
+
+    void push(std::string value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        s.append(value.data(), value.size());
+        s.seal();
+    }
+
+    bool try_pop(std::string& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (s.tail() == 0) {
+            return false;
+        }
+        Stack::Record record = s.top();
+        value.assign(s.arena() + record.offset, record.length);
+        s.drop(record);
+        return true;
+    }
+};
+
+template <typename Container>
+double operations_per_second(size_t threads, size_t operations) {
+    Container stack;
+    size_t rounds = operations / threads / 2;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+        pool.emplace_back([&stack, rounds, t] {
+            std::string value;
+            for (size_t i = 0; i < rounds; ++i) {
+                stack.push("value " + std::to_string(t));
+                stack.try_pop(value);
+            }
+        });
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(2 * rounds * threads) / seconds;
+}
+
+int main(int argc, char** argv) {
+    size_t operations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    std::printf("%7s  %16s  %16s\n", "threads", "lock-free ops/s", "mutex ops/s");
+    for (size_t threads = 1; threads <= 64; threads *= 2) {
+        double lock_free = operations_per_second<ConcurrentStack>(threads, operations);
+        double locked = operations_per_second<LockedStack>(threads, operations);
+        std::printf("%7zu  %16.3g  %16.3g\n", threads, lock_free, locked);
+    }
+    return 0;
+}
@@ -0,0 +1,257 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Lock-free multi-producer/multi-consumer string stack: a Treiber stack whose popped nodes are
+// reclaimed through hazard pointers, with an elimination array in front of it.
+//
+// A node is immutable once published, and is only freed when no thread holds a hazard on it,
+// so the pop CAS cannot suffer from ABA and back() may copy the value of the top node while
+// another thread pops it. When a CAS on the top loses a race, the thread tries to meet an
+// opposite operation in a random slot of the elimination array instead of retrying at once:
+// a pusher offers its node in an empty slot, and a popper that takes the node completes both
+// operations without touching the top. The popper leaves a taken marker in the slot, and only
+// the pusher who made the offer empties it again, so no other offer can appear in that slot
+// until the pusher has seen the outcome of its own.
+class ConcurrentStack {
+private:
+    struct Node {
+        std::string value;
+        Node* next;
+    };
+
+    // One record per live thread, shared by all stacks. Records are never unlinked; a record
+    // released by an exiting thread keeps its retired nodes for the next owner to scan.
+    struct HazardRecord {
+        std::atomic<Node*> hazard{nullptr};
+        std::atomic<bool> active{false};
+        HazardRecord* next = nullptr;
+        std::vector<Node*> retired;
+    };
+
+    struct HazardList {
+        std::atomic<HazardRecord*> head{nullptr};
+        std::atomic<size_t> count{0};
+
+        ~HazardList() {
+            HazardRecord* record = head.load();
+            while (record != nullptr) {
+                HazardRecord* next = record->next;
+                for (Node* node : record->retired) {
+                    delete node;
+                }
+                delete record;
+                record = next;
+            }
+        }
+    };
+
+    struct HazardOwner {
+        HazardRecord* record;
+
+        HazardOwner() : record(acquire_record()) {}
+
+        ~HazardOwner() {
+            record->hazard.store(nullptr);
+            record->active.store(false);
+        }
+    };
+
+    static constexpr size_t kMinScanThreshold = 64;
+    static constexpr size_t kEliminationSlots = 16;
+    static constexpr size_t kEliminationSpins = 128;
+
+    std::atomic<Node*> top{nullptr};
+    std::atomic<size_t> sz{0};
+    std::atomic<Node*> elimination[kEliminationSlots] = {};
+
+    static HazardList& hazards() {
+        static HazardList list;
+        return list;
+    }
+
+    static HazardRecord* acquire_record() {
+        HazardList& list = hazards();
+        for (HazardRecord* record = list.head.load(); record != nullptr; record = record->next) {
+            bool expected = false;
+            if (!record->active.load() && record->active.compare_exchange_strong(expected, true)) {
+                return record;
+            }
+        }
+        HazardRecord* record = new HazardRecord;
+        record->active.store(true);
+        record->next = list.head.load();
+        while (!list.head.compare_exchange_weak(record->next, record)) {
+        }
+        list.count.fetch_add(1);
+        return record;
+    }
+
+    static HazardRecord& own_record() {
+        thread_local HazardOwner owner;
+        return *owner.record;
+    }
+
+    // Publishes a hazard on the current top and re-reads the top until they agree.
+    Node* protect_top(HazardRecord& record) {
+        Node* node = top.load();
+        while (node != nullptr) {
+            record.hazard.store(node);
+            Node* current = top.load();
+            if (current == node) {
+                break;
+            }
+            node = current;
+        }
+        return node;
+    }
+
+    static void retire(HazardRecord& record, Node* node) {
+        record.retired.push_back(node);
+        if (record.retired.size() < std::max(kMinScanThreshold, 2 * hazards().count.load())) {
+            return;
+        }
+        std::vector<Node*> guarded;
+        for (HazardRecord* other = hazards().head.load(); other != nullptr; other = other->next) {
+            if (Node* hazard = other->hazard.load()) {
+                guarded.push_back(hazard);
+            }
+        }
+        std::sort(guarded.begin(), guarded.end());
+        size_t kept = 0;
+        for (Node* retired : record.retired) {
+            if (std::binary_search(guarded.begin(), guarded.end(), retired)) {
+                record.retired[kept++] = retired;
+            } else {
+                delete retired;
+            }
+        }
+        record.retired.resize(kept);
+    }
+
+    static size_t random_slot() {
+        thread_local uint64_t state = reinterpret_cast<uintptr_t>(&state) | 1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<size_t>(state % kEliminationSlots);
+    }
+
+    // Left in a slot by the popper that took the offer in it. Comparing the slot with the
+    // offered node alone would be ABA-prone: the taken node may be freed and its address offered
+    // again by another pusher.
+    static Node* taken() {
+        static Node marker;
+        return &marker;
+    }
+
+    // Offers the node to a popper for a while; true if one took it.
+    bool eliminate_push(Node* node) {
+        std::atomic<Node*>& slot = elimination[random_slot()];
+        Node* expected = nullptr;
+        if (!slot.compare_exchange_strong(expected, node)) {
+            return false;
+        }
+        for (size_t spin = 0; spin < kEliminationSpins; ++spin) {
+            if (slot.load(std::memory_order_relaxed) == taken()) {
+                break;
+            }
+        }
+        expected = node;
+        if (slot.compare_exchange_strong(expected, nullptr)) {
+            return false;
+        }
+        slot.store(nullptr);
+        return true;
+    }
+
+    // A node taken here was never published on the stack, so it is owned outright.
+    Node* eliminate_pop() {
+        std::atomic<Node*>& slot = elimination[random_slot()];
+        Node* node = slot.load();
+        if (node != nullptr && node != taken() && slot.compare_exchange_strong(node, taken())) {
+            return node;
+        }
+        return nullptr;
+    }
+
+public:
+    ConcurrentStack() = default;
+
+    ConcurrentStack(const ConcurrentStack&) = delete;
+    ConcurrentStack& operator=(const ConcurrentStack&) = delete;
+
+    // Must not race with any other operation on this stack.
+    ~ConcurrentStack() {
+        Node* node = top.load();
+        while (node != nullptr) {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+        for (std::atomic<Node*>& slot : elimination) {
+            if (slot.load() != taken()) {
+                delete slot.load();
+            }
+        }
+    }
+
+    void push(std::string value) {
+        Node* node = new Node{std::move(value), top.load(std::memory_order_relaxed)};
+        sz.fetch_add(1);
+        while (!top.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+            if (eliminate_push(node)) {
+                return;
+            }
+            node->next = top.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool try_pop(std::string& value) {
+        HazardRecord& record = own_record();
+        while (true) {
+            Node* node = protect_top(record);
+            if (node == nullptr) {
+                record.hazard.store(nullptr);
+                return false;
+            }
+            if (top.compare_exchange_strong(node, node->next)) {
+                record.hazard.store(nullptr);
+                // back() may still be copying the value under its own hazard, so copy, not move.
+                value = node->value;
+                retire(record, node);
+                sz.fetch_sub(1);
+                return true;
+            }
+            if (Node* taken = eliminate_pop()) {
+                record.hazard.store(nullptr);
+                value = std::move(taken->value);
+                delete taken;
+                sz.fetch_sub(1);
+                return true;
+            }
+        }
+    }
+
+    bool back(std::string& value) {
+        HazardRecord& record = own_record();
+        Node* node = protect_top(record);
+        if (node != nullptr) {
+            value = node->value;
+        }
+        record.hazard.store(nullptr);
+        return node != nullptr;
+    }
+
+    // Exact when the stack is quiescent; under contention it may count a push in progress.
+    size_t size() const {
+        return sz.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+};
@@ -0,0 +1,239 @@
+#include "stack.h"
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+
+// Usage: generate [--bench] [--seed=N] commands
+// Writes a random stream of the given number of text commands for stack, ending with exit:
+// mostly push of 1-16 character values, with pop, back, size and the odd clear. Only commands
+// the original per-line loop knew are used, so that
+//   generate 10000000 > commands.txt && stack < commands.txt > /dev/null
+// can be timed against a build of that loop. With --bench nothing is printed to stdout: the
+// stream goes to a temporary file, which both the run loop of stack.h and the original loop
+// (kept below as legacy_main) process into files of their own; the two outputs are compared
+// byte for byte and the commands per second of each are printed on stderr.
+
+// The std::cin / std::cout loop that stack.cpp had before the buffered protocol.
+struct LegacyStack {
+    char** data;
+    size_t sz;
+    size_t cap;
+
+    LegacyStack() : data(nullptr), sz(0), cap(0) {}
+
+    ~LegacyStack() {
+        for (size_t i = 0; i < sz; ++i) {
+            delete[] data[i];
+        }
+        delete[] data;
+    }
+
+    void push(const char* str) {
+        if (cap == 0) {
+            cap = 8;
+            data = new char*[cap];
+        } else if (sz == cap) {
+            cap *= 2;
+            char** new_data = new char*[cap];
+            std::memcpy(new_data, data, sz * sizeof(char*));
+            delete[] data;
+            data = new_data;
+        }
+        data[sz] = new char[std::strlen(str) + 1];
+        std::strcpy(data[sz++], str);
+        std::cout << "ok\n";
+    }
+
+    void pop() {
+        if (sz == 0) {
+            std::cout << "error\n";
+            return;
+        }
+        std::cout << data[--sz] << "\n";
+        delete[] data[sz];
+    }
+
+    void back() {
+        if (sz == 0) {
+            std::cout << "error\n";
+            return;
+        }
+        std::cout << data[sz - 1] << "\n";
+    }
+
+    void size() {
+        std::cout << sz << "\n";
+    }
+
+    void clear() {
+        for (size_t i = 0; i < sz; ++i) {
+            delete[] data[i];
+        }
+        sz = 0;
+        std::cout << "ok\n";
+    }
+};
+
+static void legacy_main() {
+    LegacyStack s;
+    char command[16];
+
+    while (true) {
+        std::cin >> command;
+        if (std::strcmp(command, "push") == 0) {
+            char buffer[1024];
+            std::cin >> buffer;
+            s.push(buffer);
+        } else if (std::strcmp(command, "pop") == 0) {
+            s.pop();
+        } else if (std::strcmp(command, "back") == 0) {
+            s.back();
+        } else if (std::strcmp(command, "size") == 0) {
+            s.size();
+        } else if (std::strcmp(command, "clear") == 0) {
+            s.clear();
+        } else if (std::strcmp(command, "exit") == 0) {
+            std::cout << "bye\n";
+            break;
+        } else {
+            std::cout << "unknown command\n";
+            break;
+        }
+    }
+}
+
+static std::string generate(uint64_t seed, size_t commands) {
+    static const char kAlphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    std::mt19937_64 rng(seed);
+    std::string text;
+    for (size_t i = 0; i + 1 < commands; ++i) {
+        uint64_t kind = rng() % 1000;
+        if (kind < 500) {
+            text += "push ";
+            size_t length = 1 + rng() % 16;
+            for (size_t j = 0; j < length; ++j) {
+                text += kAlphabet[rng() % (sizeof(kAlphabet) - 1)];
+            }
+            text += '\n';
+        } else if (kind < 800) {
+            text += "pop\n";
+        } else if (kind < 900) {
+            text += "back\n";
+        } else if (kind < 999) {
+            text += "size\n";
+        } else {
+            text += "clear\n";
+        }
+    }
+    if (commands != 0) {
+        text += "exit\n";
+    }
+    return text;
+}
+
+static int temporary_file(const char* name) {
+    std::string path = std::string("/tmp/stack_") + name + "_XXXXXX";
+    int fd = ::mkstemp(path.data());
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "mkstemp");
+    }
+    ::unlink(path.c_str());
+    return fd;
+}
+
+static std::string contents(int fd) {
+    std::string text(static_cast<size_t>(::lseek(fd, 0, SEEK_END)), '\0');
+    if (::pread(fd, text.data(), text.size(), 0) != static_cast<ssize_t>(text.size())) {
+        throw std::system_error(errno, std::generic_category(), "pread");
+    }
+    return text;
+}
+
+static int bench(const std::string& text, size_t commands) {
+    int input = temporary_file("input");
+    Output::write_all(input, text.data(), text.size());
+
+    int buffered_output = temporary_file("buffered");
+    auto start = std::chrono::steady_clock::now();
+    {
+        Output out(buffered_output);
+        Input in(out, input);
+        Stack s(out);
+        run(in, s, out);
+    }
+    double buffered = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // The legacy loop reads std::cin and writes std::cout, so it gets the same input and a
+    // file of its own as descriptors 0 and 1.
+    int legacy_output = temporary_file("legacy");
+    int saved_stdout = ::dup(STDOUT_FILENO);
+    ::lseek(input, 0, SEEK_SET);
+    ::dup2(input, STDIN_FILENO);
+    ::dup2(legacy_output, STDOUT_FILENO);
+    start = std::chrono::steady_clock::now();
+    legacy_main();
+    std::cout.flush();
+    double legacy = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ::dup2(saved_stdout, STDOUT_FILENO);
+
+    bool identical = contents(buffered_output) == contents(legacy_output);
+    auto rate = [&](double seconds) { return static_cast<double>(commands) / seconds; };
+    std::cerr << text.size() << " bytes, " << commands << " commands\n"
+              << "per-line loop: " << legacy << " s, " << rate(legacy) << " commands/s\n"
+              << "buffered:      " << buffered << " s, " << rate(buffered) << " commands/s ("
+              << legacy / buffered << "x)\n"
+              << (identical ? "outputs are identical\n" : "outputs differ\n");
+    return identical ? 0 : 1;
+}
+
+// Non-negative decimal number, or false.
+static bool parse_number(const char* str, uint64_t& value) {
+    std::from_chars_result result = std::from_chars(str, str + std::strlen(str), value);
+    return result.ec == std::errc() && *result.ptr == '\0' && result.ptr != str;
+}
+
+int main(int argc, char** argv) {
+    bool run_bench = false;
+    uint64_t seed = 42;
+    uint64_t commands = 0;
+    bool have_count = false;
+    for (int i = 1; i < argc; ++i) {
+        bool ok;
+        if (std::strcmp(argv[i], "--bench") == 0) {
+            run_bench = ok = true;
+        } else if (std::strncmp(argv[i], "--seed=", 7) == 0) {
+            ok = parse_number(argv[i] + 7, seed);
+        } else {
+            ok = !have_count && parse_number(argv[i], commands);
+            have_count = true;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "invalid argument '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!have_count) {
+        std::fprintf(stderr, "usage: generate [--bench] [--seed=N] commands\n");
+        return 1;
+    }
+    // Without its exit the legacy loop never stops.
+    if (run_bench && commands == 0) {
+        std::fprintf(stderr, "--bench needs at least one command\n");
+        return 1;
+    }
+
+    std::string text = generate(seed, commands);
+    if (run_bench) {
+        try {
+            return bench(text, commands);
+        } catch (const std::system_error& error) {
+            std::fprintf(stderr, "%s\n", error.what());
+            return 1;
+        }
+    }
+    Output::write_all(STDOUT_FILENO, text.data(), text.size());
+    return 0;
+}
@@ -1,93 +1,32 @@
-#include <iostream>
-#include <cstring>
-
-struct Stack {
-    char** data;
-    size_t sz;
-    size_t cap;
-
-    Stack() : data(nullptr), sz(0), cap(0) {}
-
-    ~Stack() {
-        for (size_t i = 0; i < sz; ++i) {
-            delete[] data[i];
-        }
-        delete[] data;
-    }
-
-    void push(const char* str) {
-        if (cap == 0) {
-            cap = 8;
-            data = new char*[cap];
-        } else if (sz == cap) {
-            cap *= 2;
-            char** new_data = new char*[cap];
-            std::memcpy(new_data, data, sz * sizeof(char*));
-            delete[] data;
-            data = new_data;
-        }
-        data[sz] = new char[std::strlen(str) + 1];
-        std::strcpy(data[sz++], str);
-        std::cout << "ok\n";
-    }
-
-    void pop() {
-        if (sz == 0) {
-            std::cout << "error\n";
-            return;
-        }
-        std::cout << data[--sz] << "\n";
-        delete[] data[sz];
-    }
-
-    void back() {
-        if (sz == 0) {
-            std::cout << "error\n";
-            return;
-        }
-        std::cout << data[sz - 1] << "\n";
-    }
-
-    void size() {
-        std::cout << sz << "\n";
-    }
-
-    void clear() {
-        for (size_t i = 0; i < sz; ++i) {
-            delete[] data[i];
+#include "stack.h"
+
+// Usage: stack [--binary] [file]. With a file the stack is kept in it and picks up where it
+// was left; --binary switches from the text protocol to length-prefixed frames.
+int main(int argc, char** argv) {
+    bool binary = argc > 1 && std::strcmp(argv[1], "--binary") == 0;
+    const char* path = argc > (binary ? 2 : 1) ? argv[binary ? 2 : 1] : nullptr;
+    Output out;
+    Input in(out);
+    Stack s(out);
+    if (path != nullptr) {
+        try {
+            s.open(path);
+        } catch (const std::exception& error) {
+            std::fprintf(stderr, "%s: %s\n", path, error.what());
+            return 1;
         }
-        sz = 0;
-        std::cout << "ok\n";
     }
-};
-
-int main() {
-    Stack s;
-    char command[16];
 
-    while (true) {
-        std::cin >> command;
-        if (std::strcmp(command, "push") == 0) {
-            char buffer[1024];
-            std::cin >> buffer;
-            s.push(buffer);
-        } else if (std::strcmp(command, "pop") == 0) {
-            s.pop();
-        } else if (std::strcmp(command, "back") == 0) {
-            s.back();
-        } else if (std::strcmp(command, "size") == 0) {
-            s.size();
-        } else if (std::strcmp(command, "clear") == 0) {
-            s.clear();
-        } else if (std::strcmp(command, "exit") == 0) {
-            std::cout << "bye\n";
-            break;
+    try {
+        if (binary) {
+            run_binary(in, s, out);
         } else {
-            std::cout << "unknown command\n";
-            break;
+            run(in, s, out);
         }
+    } catch (const std::system_error& error) {
+        out.flush();
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
     }
-
     return 0;
 }
-
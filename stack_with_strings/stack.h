@@ -0,0 +1,713 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Responses are accumulated in a large buffer and handed to write(2) in bulk.
+struct Output {
+    static constexpr size_t kCapacity = 1 << 20;
+
+    int fd;
+    char* buffer;
+    size_t sz;
+
+    explicit Output(int descriptor = STDOUT_FILENO) : fd(descriptor), buffer(new char[kCapacity]), sz(0) {}
+
+    ~Output() {
+        flush();
+        delete[] buffer;
+    }
+
+    static void write_all(int fd, const char* str, size_t length) {
+        while (length != 0) {
+            ssize_t written = ::write(fd, str, length);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            str += written;
+            length -= static_cast<size_t>(written);
+        }
+    }
+
+    void flush() {
+        write_all(fd, buffer, sz);
+        sz = 0;
+    }
+
+    void write(const char* str, size_t length) {
+        if (length > kCapacity - sz) {
+            flush();
+            if (length > kCapacity) {
+                write_all(fd, str, length);
+                return;
+            }
+        }
+        std::memcpy(buffer + sz, str, length);
+        sz += length;
+    }
+
+    void line(const char* str, size_t length) {
+        write(str, length);
+        write("\n", 1);
+    }
+
+    void line(size_t value) {
+        char digits[24];
+        char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        *end++ = '\n';
+        write(digits, static_cast<size_t>(end - digits));
+    }
+};
+
+// Whitespace-separated tokens straight from stdin (or another descriptor). A regular file is mapped whole and tokens
+// point into the mapping; anything else is read in large blocks, and a command cut by a block
+// boundary is moved to the front of the buffer before the next read. Pending output is
+// flushed before every blocking read so that interactive sessions still see responses.
+struct Input {
+    static constexpr size_t kBlockSize = 1 << 20;
+
+    Output& out;
+    int fd;
+    char* data;
+    size_t pos;
+    size_t end;
+    size_t cap;
+    bool mapped;
+    bool eof;
+
+    explicit Input(Output& output, int descriptor = STDIN_FILENO)
+        : out(output), fd(descriptor), data(nullptr), pos(0), end(0), cap(0), mapped(false), eof(false) {
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* file = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (file != MAP_FAILED) {
+                ::madvise(file, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+                data = static_cast<char*>(file);
+                end = static_cast<size_t>(info.st_size);
+                mapped = true;
+                eof = true;
+                return;
+            }
+        }
+        cap = kBlockSize;
+        data = new char[cap];
+    }
+
+    ~Input() {
+        if (mapped) {
+            ::munmap(data, end);
+        } else {
+            delete[] data;
+        }
+    }
+
+    static bool is_space(char c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    // Appends the next block after end, keeping everything from keep on; returns false at eof.
+    // Unless eof was already reached, the kept bytes move to the front even when nothing more
+    // arrives, and pos moves with them.
+    bool refill(size_t keep) {
+        if (eof) {
+            return false;
+        }
+        std::memmove(data, data + keep, end - keep);
+        end -= keep;
+        pos -= keep;
+        if (end == cap) {
+            cap *= 2;
+            char* new_data = new char[cap];
+            std::memcpy(new_data, data, end);
+            delete[] data;
+            data = new_data;
+        }
+        out.flush();
+        ssize_t got;
+        do {
+            got = ::read(fd, data + end, cap - end);
+        } while (got < 0 && errno == EINTR);
+        if (got <= 0) {
+            eof = true;
+            return false;
+        }
+        end += static_cast<size_t>(got);
+        return true;
+    }
+
+    bool skip_space() {
+        while (true) {
+            while (pos < end && is_space(data[pos])) {
+                ++pos;
+            }
+            if (pos < end) {
+                return true;
+            }
+            if (!refill(end)) {
+                return false;
+            }
+        }
+    }
+
+    // The token stays valid until the next call.
+    bool next(const char*& token, size_t& length) {
+        if (!skip_space()) {
+            return false;
+        }
+        size_t begin = pos;
+        while (true) {
+            while (pos < end && !is_space(data[pos])) {
+                ++pos;
+            }
+            if (pos < end) {
+                break;
+            }
+            // refill shifts pos along with the token, also when it then finds eof.
+            size_t scanned = pos - begin;
+            bool more = refill(begin);
+            begin = pos - scanned;
+            if (!more) {
+                break;
+            }
+        }
+        token = data + begin;
+        length = pos - begin;
+        return true;
+    }
+
+    // Hands the next token to sink(piece, length) one block at a time instead of gathering it,
+    // so a token of any size passes through a buffer of kBlockSize.
+    template <typename Sink>
+    bool stream(Sink sink) {
+        if (!skip_space()) {
+            return false;
+        }
+        while (true) {
+            size_t begin = pos;
+            while (pos < end && !is_space(data[pos])) {
+                ++pos;
+            }
+            sink(data + begin, pos - begin);
+            if (pos < end || !refill(end)) {
+                return true;
+            }
+        }
+    }
+
+    // Raw bytes for the binary protocol, handed over the same way as stream.
+    template <typename Sink>
+    bool stream_bytes(size_t length, Sink sink) {
+        while (length != 0) {
+            if (pos == end && !refill(end)) {
+                return false;
+            }
+            size_t piece = std::min(length, end - pos);
+            sink(data + pos, piece);
+            pos += piece;
+            length -= piece;
+        }
+        return true;
+    }
+
+    bool read(void* dst, size_t length) {
+        char* p = static_cast<char*>(dst);
+        return stream_bytes(length, [&p](const char* piece, size_t size) {
+            std::memcpy(p, piece, size);
+            p += size;
+        });
+    }
+};
+
+// All strings live back to back in one arena, each followed by its record: the offset and the
+// length of the value, and its index from the bottom. The top record therefore always ends at
+// the tail, pop rewinds the tail to the start of the top value and clear resets it, and the
+// arena grows in large geometric steps, so no operation touches the allocator per element.
+//
+// The arena starts with a header and is either heap memory or, in file-backed mode, a shared
+// mapping of a file that survives restarts. The tail in the header is the only commit point:
+// a push writes the value and its record first and then publishes the new tail with a release
+// store, so a crash at any moment leaves the file at the last completed command. The file
+// belongs to one process at a time, which open enforces with an exclusive flock.
+struct Stack {
+    static constexpr size_t kMinCapacity = 1 << 16;
+    // Upper bound on the arena, far above any real stack; a request beyond it is refused
+    // before anything is allocated, and doubling below it cannot overflow.
+    static constexpr uint64_t kMaxSize = uint64_t(1) << 46;
+
+    struct Header {
+        static constexpr char kMagic[8] = {'S', 'T', 'R', 'S', 'T', 'A', 'C', 'K'};
+        static constexpr uint32_t kVersion = 1;
+        static constexpr uint32_t kByteOrder = 0x01020304;
+
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t tail;
+        uint64_t reserved;
+    };
+
+    struct Record {
+        uint64_t offset;
+        uint64_t length;
+        uint64_t index;
+    };
+
+    Output& out;
+    int fd;
+    char* base;
+    size_t cap;
+    size_t cursor;
+
+    explicit Stack(Output& output) : out(output), fd(-1), base(new char[kMinCapacity]), cap(kMinCapacity), cursor(0) {
+        init_header();
+    }
+
+    ~Stack() {
+        if (fd < 0) {
+            delete[] base;
+            return;
+        }
+        ::msync(base, cap, MS_SYNC);
+        ::munmap(base, cap);
+        ::close(fd);
+    }
+
+    Header* header() {
+        return reinterpret_cast<Header*>(base);
+    }
+
+    char* arena() {
+        return base + sizeof(Header);
+    }
+
+    uint64_t tail() {
+        return __atomic_load_n(&header()->tail, __ATOMIC_ACQUIRE);
+    }
+
+    void set_tail(uint64_t tail) {
+        __atomic_store_n(&header()->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    Record top() {
+        Record record;
+        std::memcpy(&record, arena() + tail() - sizeof(Record), sizeof(Record));
+        return record;
+    }
+
+    void init_header() {
+        Header* h = header();
+        std::memcpy(h->magic, Header::kMagic, sizeof(h->magic));
+        h->version = Header::kVersion;
+        h->byte_order = Header::kByteOrder;
+        h->tail = 0;
+        h->reserved = 0;
+    }
+
+    bool valid_header(size_t size) {
+        Header* h = header();
+        if (std::memcmp(h->magic, Header::kMagic, sizeof(h->magic)) != 0 || h->version != Header::kVersion
+            || h->byte_order != Header::kByteOrder || h->tail > size - sizeof(Header)) {
+            return false;
+        }
+        if (h->tail == 0) {
+            return true;
+        }
+        if (h->tail < sizeof(Record)) {
+            return false;
+        }
+        Record record = top();
+        return record.offset <= h->tail - sizeof(Record) && record.length == h->tail - sizeof(Record) - record.offset
+            && record.index <= record.offset / sizeof(Record);
+    }
+
+    // Switches to file-backed mode. An empty or missing file starts an empty stack; an existing
+    // one is mapped as is after its header and top record are validated. The file is locked
+    // with flock for as long as the stack is open, so a second process gets an error instead of
+    // a shared arena. Throws std::system_error when a system call fails and std::runtime_error
+    // when the file is not a stack file.
+    void open(const char* path) {
+        int file = ::open(path, O_RDWR | O_CREAT, 0644);
+        if (file < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot open the stack file");
+        }
+        if (::flock(file, LOCK_EX | LOCK_NB) != 0) {
+            int error = errno;
+            ::close(file);
+            if (error == EWOULDBLOCK) {
+                throw std::runtime_error("the stack file is in use by another process");
+            }
+            throw std::system_error(error, std::generic_category(), "cannot lock the stack file");
+        }
+        struct stat info;
+        if (::fstat(file, &info) != 0) {
+            int error = errno;
+            ::close(file);
+            throw std::system_error(error, std::generic_category(), "cannot stat the stack file");
+        }
+        size_t size = static_cast<size_t>(info.st_size);
+        bool fresh = size == 0;
+        if (fresh) {
+            size = kMinCapacity;
+            if (::ftruncate(file, static_cast<off_t>(size)) != 0) {
+                int error = errno;
+                ::close(file);
+                throw std::system_error(error, std::generic_category(), "cannot size the stack file");
+            }
+        } else if (size < sizeof(Header)) {
+            ::close(file);
+            throw std::runtime_error("file too small, not a stack file");
+        }
+        void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        if (mapped == MAP_FAILED) {
+            int error = errno;
+            ::close(file);
+            throw std::system_error(error, std::generic_category(), "cannot map the stack file");
+        }
+        char* previous = base;
+        base = static_cast<char*>(mapped);
+        if (fresh) {
+            init_header();
+        } else if (!valid_header(size)) {
+            ::munmap(mapped, size);
+            ::close(file);
+            base = previous;
+            throw std::runtime_error("not a stack file or damaged");
+        }
+        delete[] previous;
+        fd = file;
+        cap = size;
+        cursor = header()->tail;
+    }
+
+    void reserve(size_t required) {
+        if (sizeof(Header) + required <= cap) {
+            return;
+        }
+        if (required > kMaxSize) {
+            throw std::system_error(EFBIG, std::generic_category(), "stack size limit exceeded");
+        }
+        size_t new_cap = cap;
+        while (new_cap < sizeof(Header) + required) {
+            new_cap *= 2;
+        }
+        if (fd < 0) {
+            char* new_base = new char[new_cap];
+            std::memcpy(new_base, base, sizeof(Header) + cursor);
+            delete[] base;
+            base = new_base;
+        } else {
+            if (::ftruncate(fd, static_cast<off_t>(new_cap)) != 0) {
+                throw std::system_error(errno, std::generic_category(), "cannot grow the stack file");
+            }
+            void* mapped = ::mremap(base, cap, new_cap, MREMAP_MAYMOVE);
+            if (mapped == MAP_FAILED) {
+                throw std::system_error(errno, std::generic_category(), "cannot remap the stack file");
+            }
+            base = static_cast<char*>(mapped);
+        }
+        cap = new_cap;
+    }
+
+    // A value is streamed into the arena with any number of append calls; push then seals
+    // everything appended after the tail as a new element.
+    void append(const char* str, size_t length) {
+        reserve(cursor + length);
+        std::memcpy(arena() + cursor, str, length);
+        cursor += length;
+    }
+
+    void seal() {
+        uint64_t offset = tail();
+        Record record = {offset, cursor - offset, offset == 0 ? 0 : top().index + 1};
+        reserve(cursor + sizeof(Record));
+        std::memcpy(arena() + cursor, &record, sizeof(Record));
+        cursor += sizeof(Record);
+        set_tail(cursor);
+    }
+
+    // Removes the top element; the record must be the current top().
+    void drop(const Record& record) {
+        cursor = record.offset;
+        set_tail(cursor);
+    }
+
+    uint64_t count() {
+        return tail() == 0 ? 0 : top().index + 1;
+    }
+
+    void push() {
+        seal();
+        out.write("ok\n", 3);
+    }
+
+    void pop() {
+        if (tail() == 0) {
+            out.write("error\n", 6);
+            return;
+        }
+        Record record = top();
+        out.line(arena() + record.offset, record.length);
+        drop(record);
+    }
+
+    // All or nothing: with fewer than n elements nothing is popped. Popping none answers "ok",
+    // so that every request still gets a response line.
+    void pop(uint64_t n) {
+        if (count() < n) {
+            out.write("error\n", 6);
+            return;
+        }
+        if (n == 0) {
+            out.write("ok\n", 3);
+            return;
+        }
+        for (uint64_t i = 0; i < n; ++i) {
+            Record record = top();
+            out.line(arena() + record.offset, record.length);
+            drop(record);
+        }
+    }
+
+    void back() {
+        if (tail() == 0) {
+            out.write("error\n", 6);
+            return;
+        }
+        Record record = top();
+        out.line(arena() + record.offset, record.length);
+    }
+
+    void size() {
+        out.line(count());
+    }
+
+    void reset() {
+        cursor = 0;
+        set_tail(0);
+    }
+
+    void clear() {
+        reset();
+        out.write("ok\n", 3);
+    }
+};
+
+enum class Command {
+    Push,
+    PushN,
+    Pop,
+    PopN,
+    Back,
+    Size,
+    Clear,
+    Exit,
+    Unknown
+};
+
+// Length and last character single out each command; one memcmp confirms the rest.
+inline Command parse_command(const char* token, size_t length) {
+    auto is = [&](const char* name) { return std::memcmp(token, name, length) == 0; };
+    switch (length << 8 | static_cast<unsigned char>(token[length - 1])) {
+        case 4 << 8 | 'h': return is("push") ? Command::Push : Command::Unknown;
+        case 5 << 8 | 'n': return is("pushn") ? Command::PushN : Command::Unknown;
+        case 3 << 8 | 'p': return is("pop") ? Command::Pop : Command::Unknown;
+        case 4 << 8 | 'n': return is("popn") ? Command::PopN : Command::Unknown;
+        case 4 << 8 | 'k': return is("back") ? Command::Back : Command::Unknown;
+        case 4 << 8 | 'e': return is("size") ? Command::Size : Command::Unknown;
+        case 5 << 8 | 'r': return is("clear") ? Command::Clear : Command::Unknown;
+        case 4 << 8 | 't': return is("exit") ? Command::Exit : Command::Unknown;
+        default: return Command::Unknown;
+    }
+}
+
+inline bool parse_count(const char* token, size_t length, uint64_t& n) {
+    std::from_chars_result result = std::from_chars(token, token + length, n);
+    return result.ec == std::errc() && result.ptr == token + length;
+}
+
+// Text protocol, one command per line or any whitespace:
+//   push v | pop | back | size | clear | exit   one response line each, as always;
+//   pushn N v1 .. vN                            pushes all values and answers a single "ok";
+//   popn N                                      prints N popped values, or "error" and pops
+//                                               nothing when fewer than N are stored;
+//                                               "ok" for N = 0.
+// A count that is not a number is an unknown command.
+inline void run(Input& in, Stack& s, Output& out) {
+    const char* token;
+    size_t length;
+    uint64_t n = 0;
+    auto append = [&s](const char* piece, size_t size) { s.append(piece, size); };
+
+    while (in.next(token, length)) {
+        Command command = parse_command(token, length);
+        if (command == Command::PushN || command == Command::PopN) {
+            if (!in.next(token, length)) {
+                return;
+            }
+            if (!parse_count(token, length, n)) {
+                command = Command::Unknown;
+            }
+        }
+        switch (command) {
+            case Command::Push:
+                if (!in.stream(append)) {
+                    return;
+                }
+                s.push();
+                break;
+            case Command::PushN:
+                for (uint64_t i = 0; i < n; ++i) {
+                    if (!in.stream(append)) {
+                        return;
+                    }
+                    s.seal();
+                }
+                out.write("ok\n", 3);
+                break;
+            case Command::Pop:
+                s.pop();
+                break;
+            case Command::PopN:
+                s.pop(n);
+                break;
+            case Command::Back:
+                s.back();
+                break;
+            case Command::Size:
+                s.size();
+                break;
+            case Command::Clear:
+                s.clear();
+                break;
+            case Command::Exit:
+                out.write("bye\n", 4);
+                return;
+            case Command::Unknown:
+                out.write("unknown command\n", 16);
+                return;
+        }
+    }
+}
+
+// Binary protocol, in host byte order. A request is a frame
+//   uint8 opcode, uint32 n, payload
+// with opcodes 1 push (payload: uint64 lengths[n], then the n values back to back), 2 pop
+// (n values), 3 back, 4 size, 5 clear, 6 exit. The response starts with a status byte: 0 ok,
+// 1 error (empty stack, or fewer than n elements for pop, which then pops nothing), 2 unknown
+// opcode, after which the stream ends. pop and back follow an ok status with uint64 length
+// and value per element, size with a uint64 count. A push batch takes one storage reservation;
+// one whose lengths add up to more than Stack::kMaxSize is answered with error without reading
+// its values, and the stream ends there as well, since the values cannot be skipped.
+enum class Opcode : uint8_t {
+    Push = 1,
+    Pop = 2,
+    Back = 3,
+    Size = 4,
+    Clear = 5,
+    Exit = 6
+};
+
+inline void write_status(Output& out, uint8_t status) {
+    out.write(reinterpret_cast<const char*>(&status), 1);
+}
+
+inline void write_value(Output& out, const char* value, uint64_t length) {
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(value, length);
+}
+
+inline void run_binary(Input& in, Stack& s, Output& out) {
+    static constexpr uint8_t kOk = 0;
+    static constexpr uint8_t kError = 1;
+    static constexpr uint8_t kUnknown = 2;
+
+    std::vector<uint64_t> lengths;
+    auto append = [&s](const char* piece, size_t size) { s.append(piece, size); };
+    uint8_t opcode;
+    uint32_t n;
+
+    while (in.read(&opcode, sizeof(opcode)) && in.read(&n, sizeof(n))) {
+        switch (static_cast<Opcode>(opcode)) {
+            case Opcode::Push: {
+                lengths.clear();
+                // Each length and the running total stay below kMaxSize, so the sums cannot wrap.
+                uint64_t total = s.cursor + uint64_t(n) * sizeof(Stack::Record);
+                bool fits = total <= Stack::kMaxSize;
+                for (uint32_t i = 0; i < n; ++i) {
+                    uint64_t length;
+                    if (!in.read(&length, sizeof(length))) {
+                        return;
+                    }
+                    lengths.push_back(length);
+                    fits = fits && length <= Stack::kMaxSize - total;
+                    if (fits) {
+                        total += length;
+                    }
+                }
+                if (!fits) {
+                    write_status(out, kError);
+                    return;
+                }
+                s.reserve(total);
+                for (uint64_t length : lengths) {
+                    if (!in.stream_bytes(length, append)) {
+                        return;
+                    }
+                    s.seal();
+                }
+                write_status(out, kOk);
+                break;
+            }
+            case Opcode::Pop:
+                if (s.count() < n) {
+                    write_status(out, kError);
+                    break;
+                }
+                write_status(out, kOk);
+                for (uint32_t i = 0; i < n; ++i) {
+                    Stack::Record record = s.top();
+                    write_value(out, s.arena() + record.offset, record.length);
+                    s.drop(record);
+                }
+                break;
+            case Opcode::Back:
+                if (s.count() == 0) {
+                    write_status(out, kError);
+                    break;
+                }
+                write_status(out, kOk);
+                write_value(out, s.arena() + s.top().offset, s.top().length);
+                break;
+            case Opcode::Size: {
+                uint64_t count = s.count();
+                write_status(out, kOk);
+                out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+                break;
+            }
+            case Opcode::Clear:
+                s.reset();
+                write_status(out, kOk);
+                break;
+            case Opcode::Exit:
+                write_status(out, kOk);
+                return;
+            default:
+                write_status(out, kUnknown);
+                return;
+        }
+    }
+}
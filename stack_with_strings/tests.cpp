@@ -0,0 +1,287 @@
+#include "concurrent_stack.h"
+#include "stack.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------- Однопоточное поведение ----------
+TEST(ConcurrentStackTest, EmptyStack) {
+    ConcurrentStack s;
+    std::string value = "untouched";
+    EXPECT_TRUE(s.empty());
+    EXPECT_FALSE(s.try_pop(value));
+    EXPECT_FALSE(s.back(value));
+    EXPECT_EQ(value, "untouched");
+}
+
+TEST(ConcurrentStackTest, LastInFirstOut) {
+    ConcurrentStack s;
+    s.push("a");
+    s.push("bb");
+    s.push(std::string(100000, 'c'));
+    EXPECT_EQ(s.size(), 3);
+
+    std::string value;
+    ASSERT_TRUE(s.back(value));
+    EXPECT_EQ(value, std::string(100000, 'c'));
+    ASSERT_TRUE(s.try_pop(value));
+    EXPECT_EQ(value, std::string(100000, 'c'));
+    ASSERT_TRUE(s.try_pop(value));
+    EXPECT_EQ(value, "bb");
+    ASSERT_TRUE(s.back(value));
+    EXPECT_EQ(value, "a");
+    ASSERT_TRUE(s.try_pop(value));
+    EXPECT_EQ(value, "a");
+    EXPECT_FALSE(s.try_pop(value));
+    EXPECT_EQ(s.size(), 0);
+}
+
+TEST(ConcurrentStackTest, DestroyNonEmpty) {
+    ConcurrentStack s;
+    for (int i = 0; i < 1000; ++i) {
+        s.push(std::to_string(i));
+    }
+    EXPECT_EQ(s.size(), 1000);
+}
+
+// ---------- Многопоточная нагрузка ----------
+std::string stress_value(size_t producer, size_t index) {
+    return std::to_string(producer) + ":" + std::to_string(index);
+}
+
+// Every pushed value must be popped exactly once, and the stack must end up empty.
+void run_stress(size_t producers, size_t consumers, size_t per_producer) {
+    ConcurrentStack s;
+    std::atomic<size_t> popped{0};
+    std::atomic<size_t> duplicates{0};
+    std::atomic<size_t> malformed{0};
+    size_t total = producers * per_producer;
+    std::vector<std::atomic<uint8_t>> seen(total);
+
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (size_t i = 0; i < per_producer; ++i) {
+                s.push(stress_value(p, i));
+            }
+        });
+    }
+    for (size_t c = 0; c < consumers; ++c) {
+        threads.emplace_back([&] {
+            std::string value;
+            while (popped.load() < total) {
+                if (!s.try_pop(value)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                size_t colon = value.find(':');
+                size_t p = std::stoul(value.substr(0, colon));
+                size_t i = std::stoul(value.substr(colon + 1));
+                if (p >= producers || i >= per_producer || value != stress_value(p, i)) {
+                    malformed.fetch_add(1);
+                } else if (seen[p * per_producer + i].exchange(1) != 0) {
+                    duplicates.fetch_add(1);
+                }
+                popped.fetch_add(1);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(popped.load(), total);
+    EXPECT_EQ(duplicates.load(), 0);
+    EXPECT_EQ(malformed.load(), 0);
+    EXPECT_EQ(s.size(), 0);
+    std::string value;
+    EXPECT_FALSE(s.try_pop(value));
+}
+
+TEST(ConcurrentStackStressTest, ProducersAndConsumers) {
+    run_stress(4, 4, 50000);
+}
+
+TEST(ConcurrentStackStressTest, ManyThreads) {
+    run_stress(16, 16, 5000);
+}
+
+TEST(ConcurrentStackStressTest, MixedPushPopPerThread) {
+    ConcurrentStack s;
+    constexpr size_t kThreads = 8;
+    constexpr size_t kRounds = 20000;
+    std::atomic<size_t> pops{0};
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            std::string value;
+            for (size_t i = 0; i < kRounds; ++i) {
+                s.push(stress_value(t, i));
+                if (s.try_pop(value)) {
+                    pops.fetch_add(1);
+                }
+                s.back(value);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    size_t left = 0;
+    std::string value;
+    while (s.try_pop(value)) {
+        ++left;
+    }
+    EXPECT_EQ(pops.load() + left, kThreads * kRounds);
+}
+
+TEST(ConcurrentStackStressTest, BackWhilePopping) {
+    ConcurrentStack s;
+    constexpr size_t kValues = 100000;
+    const std::string filler(64, 'x');
+    for (size_t i = 0; i < kValues; ++i) {
+        s.push(filler + std::to_string(i));
+    }
+
+    std::atomic<bool> done{false};
+    std::atomic<size_t> malformed{0};
+    std::thread reader([&] {
+        std::string value;
+        while (!done.load()) {
+            if (s.back(value) && value.compare(0, filler.size(), filler) != 0) {
+                malformed.fetch_add(1);
+            }
+        }
+    });
+    std::vector<std::thread> poppers;
+    for (size_t t = 0; t < 4; ++t) {
+        poppers.emplace_back([&] {
+            std::string value;
+            while (s.try_pop(value)) {
+            }
+        });
+    }
+    for (std::thread& popper : poppers) {
+        popper.join();
+    }
+    done.store(true);
+    reader.join();
+
+    EXPECT_EQ(malformed.load(), 0);
+    EXPECT_TRUE(s.empty());
+}
+
+// ---------- Протокол через канал ----------
+// Feeds input through a pipe in pieces of the given size, as a shell pipeline would, and
+// returns everything the protocol wrote.
+std::string run_pipe(const std::string& input, size_t piece, bool binary) {
+    int fds[2];
+    EXPECT_EQ(::pipe(fds), 0);
+    std::thread writer([&] {
+        for (size_t i = 0; i < input.size(); i += piece) {
+            Output::write_all(fds[1], input.data() + i, std::min(piece, input.size() - i));
+        }
+        ::close(fds[1]);
+    });
+    std::FILE* result = std::tmpfile();
+    {
+        Output out(::fileno(result));
+        Input in(out, fds[0]);
+        Stack s(out);
+        if (binary) {
+            run_binary(in, s, out);
+        } else {
+            run(in, s, out);
+        }
+    }
+    writer.join();
+    ::close(fds[0]);
+
+    std::string output;
+    std::rewind(result);
+    char buffer[4096];
+    size_t got;
+    while ((got = std::fread(buffer, 1, sizeof(buffer), result)) != 0) {
+        output.append(buffer, got);
+    }
+    std::fclose(result);
+    return output;
+}
+
+std::string run_text_pipe(const std::string& input, size_t piece) {
+    return run_pipe(input, piece, false);
+}
+
+std::string run_binary_pipe(const std::string& input) {
+    return run_pipe(input, 1 << 10, true);
+}
+
+TEST(StackPipeTest, LastTokenWithoutNewline) {
+    EXPECT_EQ(run_text_pipe("push a\nexit", 1 << 10), "ok\nbye\n");
+    EXPECT_EQ(run_text_pipe("push a\nback", 1 << 10), "ok\na\n");
+    EXPECT_EQ(run_text_pipe("push a\nexit", 1), "ok\nbye\n");
+    EXPECT_EQ(run_text_pipe("push abc\npop", 3), "ok\nabc\n");
+}
+
+TEST(StackPipeTest, TokensAcrossReads) {
+    std::string input;
+    std::string expected;
+    for (size_t i = 0; i < 2000; ++i) {
+        input += "push value" + std::to_string(i) + "\nsize\n";
+        expected += "ok\n" + std::to_string(i + 1) + "\n";
+    }
+    input += "pop\nback";
+    expected += "value1999\nvalue1998\n";
+    EXPECT_EQ(run_text_pipe(input, 7), expected);
+}
+
+TEST(StackPipeTest, PopNothing) {
+    EXPECT_EQ(run_text_pipe("push a\npopn 0\nsize\npopn 2\npopn 1\n", 1 << 10), "ok\nok\n1\nerror\na\n");
+}
+
+// A push frame declaring a huge value is refused at once instead of growing the arena.
+TEST(StackPipeTest, BinaryPushTooLarge) {
+    std::string frame(1, '\x01');
+    uint32_t n = 2;
+    uint64_t lengths[2] = {1, uint64_t(1) << 63};
+    frame.append(reinterpret_cast<const char*>(&n), sizeof(n));
+    frame.append(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+    frame += "x";
+    EXPECT_EQ(run_binary_pipe(frame), std::string(1, '\x01'));
+}
+
+// ---------- Файловый режим ----------
+TEST(StackFileTest, RejectsShortFile) {
+    char path[] = "/tmp/stack_short_XXXXXX";
+    int fd = ::mkstemp(path);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::write(fd, "abc", 3), 3);
+    ::close(fd);
+    Output out;
+    Stack s(out);
+    try {
+        s.open(path);
+        ADD_FAILURE() << "a 3-byte file was accepted";
+    } catch (const std::runtime_error& error) {
+        EXPECT_NE(std::string(error.what()).find("too small"), std::string::npos);
+    }
+    ::unlink(path);
+}
+
+TEST(StackFileTest, SecondOpenIsLockedOut) {
+    char path[] = "/tmp/stack_lock_XXXXXX";
+    int fd = ::mkstemp(path);
+    ASSERT_GE(fd, 0);
+    ::close(fd);
+    Output out;
+    Stack first(out);
+    first.open(path);
+    Stack second(out);
+    EXPECT_THROW(second.open(path), std::runtime_error);
+    ::unlink(path);
+}
@@ -0,0 +1,90 @@
+#include "string.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+// Usage: bench_utf8 [megabytes]
+// Builds mostly-ASCII UTF-8 text (64 MB by default, one byte in ten starts a two-, three- or
+// four-byte sequence) and prints the throughput in GB/s of validation, code point counting and
+// ASCII lower-casing for the scalar loops, the SSE versions, the AVX2 versions when the CPU has
+// AVX2, and the String methods, which pick one of them at run time. Build with
+//   g++ -std=c++17 -O2 bench_utf8.cpp
+
+template <typename Func>
+static double best_seconds(Func func){
+	double best = 0;
+	for(int run = 0; run < 5; ++run){
+		auto start = std::chrono::steady_clock::now();
+		func();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		best = run == 0 ? seconds : std::min(best, seconds);
+	}
+	return best;
+}
+
+// result is the validation outcome or the code point count, so that the versions can be
+// compared; lower-casing has none.
+static void report(const char* operation, const char* version, size_t size, double seconds, size_t result = SIZE_MAX){
+	std::printf("%-10s %-7s %8.2f GB/s", operation, version, static_cast<double>(size) / seconds / 1e9);
+	if(result != SIZE_MAX){std::printf("  (%zu)", result);}
+	std::printf("\n");
+}
+
+int main(int argc, char** argv){
+	size_t size = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64) << 20;
+	const char* sequences[] = {"\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80"};
+	std::mt19937 rng(1);
+	std::string text;
+	text.reserve(size + 4);
+	while(text.size() < size){
+		unsigned value = static_cast<unsigned>(rng() % 100);
+		if(value < 10){
+			text += sequences[value % 3];
+		} else{
+			text += static_cast<char>(value < 60 ? 'a' + value % 26 : value < 90 ? 'A' + value % 26 : ' ');
+		}
+	}
+	size = text.size();
+	String string(text.c_str());
+	unsigned char* p = reinterpret_cast<unsigned char*>(string.data());
+	using namespace utf8_detail;
+
+	bool valid = false;
+	size_t count = 0;
+	double seconds = best_seconds([&]{ valid = valid_scalar(p, size); });
+	report("validate", "scalar", size, seconds, valid);
+	seconds = best_seconds([&]{ count = count_scalar(p, size); });
+	report("count", "scalar", size, seconds, count);
+	seconds = best_seconds([&]{ flip_case_scalar(p, size, 'A'); flip_case_scalar(p, size, 'a'); });
+	report("lower", "scalar", size, seconds / 2);
+
+#ifdef __x86_64__
+	if(__builtin_cpu_supports("ssse3")){
+		seconds = best_seconds([&]{ valid = valid_ssse3(p, size); });
+		report("validate", "ssse3", size, seconds, valid);
+	}
+	seconds = best_seconds([&]{ count = count_sse2(p, size); });
+	report("count", "sse2", size, seconds, count);
+	seconds = best_seconds([&]{ flip_case_sse2(p, size, 'A'); flip_case_sse2(p, size, 'a'); });
+	report("lower", "sse2", size, seconds / 2);
+	if(__builtin_cpu_supports("avx2")){
+		seconds = best_seconds([&]{ valid = valid_avx2(p, size); });
+		report("validate", "avx2", size, seconds, valid);
+		seconds = best_seconds([&]{ count = count_avx2(p, size); });
+		report("count", "avx2", size, seconds, count);
+		seconds = best_seconds([&]{ flip_case_avx2(p, size, 'A'); flip_case_avx2(p, size, 'a'); });
+		report("lower", "avx2", size, seconds / 2);
+	}
+#endif
+
+	seconds = best_seconds([&]{ valid = string.is_valid_utf8(); });
+	report("validate", "String", size, seconds, valid);
+	seconds = best_seconds([&]{ count = string.codepoint_count(); });
+	report("count", "String", size, seconds, count);
+	seconds = best_seconds([&]{ string.to_lower_ascii(); string.to_upper_ascii(); });
+	report("lower", "String", size, seconds / 2);
+	return 0;
+}
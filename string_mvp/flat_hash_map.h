@@ -0,0 +1,188 @@
+#pragma once
+#include "string.h"
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// Open-addressing hash map keyed by String. Entries are stored densely, in insertion order until
+// an erase moves the last entry into the hole; the table only holds, per slot, the full hash
+// and the index of the entry, and is probed linearly. Keys are compared only on a full hash
+// match, so a lookup usually reads one slot and one entry, and growing the table never copies
+// a key. Lookup by const char* hashes the C string in place instead of building a String.
+// Erase shifts the following slots back rather than leaving tombstones.
+template <typename Value>
+class FlatHashMap{
+public:
+	typedef std::pair<String, Value> Entry;
+
+private:
+	struct Slot{
+		size_t hash;
+		size_t index;
+	};
+
+	static constexpr size_t kEmpty = SIZE_MAX;
+	static constexpr size_t kMinSlots = 16;
+	// The table grows once more than 7/8 of its slots would be used.
+	static constexpr size_t kLoadNumerator = 7;
+	static constexpr size_t kLoadDenominator = 8;
+
+	std::vector<Slot> slots;
+	std::vector<Entry> entries;
+
+	static size_t key_hash(const char* key, size_t size){
+		return static_cast<size_t>(hash_bytes(key, size));
+	}
+
+	// Slot holding the key, or the empty slot where its probe sequence ends.
+	size_t locate(size_t hash, const char* key, size_t size) const{
+		size_t mask = slots.size() - 1;
+		for(size_t pos = hash & mask;; pos = (pos + 1) & mask){
+			const Slot& slot = slots[pos];
+			if(slot.index == kEmpty){return pos;}
+			if(slot.hash == hash){
+				const String& candidate = entries[slot.index].first;
+				if(candidate.size() == size && memcmp(candidate.data(), key, size) == 0){return pos;}
+			}
+		}
+	}
+
+	size_t locate(const String& key) const{
+		return locate(key.hash(), key.data(), key.size());
+	}
+
+	void rehash(size_t slot_count){
+		slots.assign(slot_count, Slot{0, kEmpty});
+		size_t mask = slot_count - 1;
+		for(size_t i = 0; i < entries.size(); ++i){
+			size_t hash = entries[i].first.hash();
+			size_t pos = hash & mask;
+			while(slots[pos].index != kEmpty){pos = (pos + 1) & mask;}
+			slots[pos] = Slot{hash, i};
+		}
+	}
+
+	static size_t slots_for(size_t count){
+		size_t slot_count = kMinSlots;
+		while(count * kLoadDenominator > slot_count * kLoadNumerator){slot_count *= 2;}
+		return slot_count;
+	}
+
+	void erase_slot(size_t pos){
+		size_t index = slots[pos].index;
+		size_t mask = slots.size() - 1;
+		size_t hole = pos;
+		for(size_t next = (hole + 1) & mask; slots[next].index != kEmpty; next = (next + 1) & mask){
+			size_t home = slots[next].hash & mask;
+			if(((next - home) & mask) >= ((next - hole) & mask)){
+				slots[hole] = slots[next];
+				hole = next;
+			}
+		}
+		slots[hole].index = kEmpty;
+
+		size_t last = entries.size() - 1;
+		if(index != last){
+			size_t moved = entries[last].first.hash() & mask;
+			while(slots[moved].index != last){moved = (moved + 1) & mask;}
+			slots[moved].index = index;
+			entries[index] = std::move(entries[last]);
+		}
+		entries.pop_back();
+	}
+
+	Value* value_at(size_t pos){
+		return slots[pos].index == kEmpty ? nullptr : &entries[slots[pos].index].second;
+	}
+
+	const Value* value_at(size_t pos) const{
+		return slots[pos].index == kEmpty ? nullptr : &entries[slots[pos].index].second;
+	}
+
+public:
+	FlatHashMap(): slots(kMinSlots, Slot{0, kEmpty}){}
+
+	size_t size() const{
+		return entries.size();
+	}
+
+	bool empty() const{
+		return entries.empty();
+	}
+
+	void clear(){
+		entries.clear();
+		slots.assign(kMinSlots, Slot{0, kEmpty});
+	}
+
+	void reserve(size_t count){
+		entries.reserve(count);
+		if(slots_for(count) > slots.size()){rehash(slots_for(count));}
+	}
+
+	// Inserts key with value unless key is present; returns the stored value and whether it
+	// was inserted.
+	std::pair<Value*, bool> insert(const String& key, Value value){
+		if((entries.size() + 1) * kLoadDenominator > slots.size() * kLoadNumerator){rehash(slots.size() * 2);}
+		size_t pos = locate(key);
+		if(slots[pos].index != kEmpty){return {&entries[slots[pos].index].second, false};}
+		slots[pos] = Slot{key.hash(), entries.size()};
+		entries.emplace_back(key, std::move(value));
+		return {&entries.back().second, true};
+	}
+
+	Value& operator[](const String& key){
+		return *insert(key, Value()).first;
+	}
+
+	Value* find(const String& key){
+		return value_at(locate(key));
+	}
+
+	const Value* find(const String& key) const{
+		return value_at(locate(key));
+	}
+
+	Value* find(const char* key){
+		size_t size = strlen(key);
+		return value_at(locate(key_hash(key, size), key, size));
+	}
+
+	const Value* find(const char* key) const{
+		size_t size = strlen(key);
+		return value_at(locate(key_hash(key, size), key, size));
+	}
+
+	bool contains(const String& key) const{
+		return find(key) != nullptr;
+	}
+
+	bool contains(const char* key) const{
+		return find(key) != nullptr;
+	}
+
+	bool erase(const String& key){
+		size_t pos = locate(key);
+		if(slots[pos].index == kEmpty){return false;}
+		erase_slot(pos);
+		return true;
+	}
+
+	bool erase(const char* key){
+		size_t size = strlen(key);
+		size_t pos = locate(key_hash(key, size), key, size);
+		if(slots[pos].index == kEmpty){return false;}
+		erase_slot(pos);
+		return true;
+	}
+
+	// Entries in storage order; keys are const because the table indexes them by hash.
+	const Entry* begin() const{
+		return entries.data();
+	}
+
+	const Entry* end() const{
+		return entries.data() + entries.size();
+	}
+};
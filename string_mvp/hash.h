@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 64-bit hash of a byte range in the wyhash family: every step folds 16 bytes with one 64x64->128
+// multiply, and inputs over 48 bytes run three independent multiply chains so that the
+// multiplier stays busy. Short keys are read with a few overlapping loads and no loop.
+
+namespace hash_detail{
+	static constexpr uint64_t kSecret[4] = {0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL};
+
+	inline uint64_t mix(uint64_t a, uint64_t b){
+		__extension__ unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+		return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+	}
+
+	inline uint64_t read8(const unsigned char* p){
+		uint64_t value;
+		memcpy(&value, p, 8);
+		return value;
+	}
+
+	inline uint64_t read4(const unsigned char* p){
+		uint32_t value;
+		memcpy(&value, p, 4);
+		return value;
+	}
+
+	// 1 to 3 bytes: first, middle and last, which cover every byte.
+	inline uint64_t read3(const unsigned char* p, size_t size){
+		return (uint64_t(p[0]) << 16) | (uint64_t(p[size >> 1]) << 8) | p[size - 1];
+	}
+}
+
+inline uint64_t hash_bytes(const char* data, size_t size, uint64_t seed = 0){
+	using namespace hash_detail;
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+	seed ^= mix(seed ^ kSecret[0], kSecret[1]);
+	uint64_t a = 0;
+	uint64_t b = 0;
+	if(size <= 16){
+		if(size >= 4){
+			size_t shift = (size >> 3) << 2;
+			a = (read4(p) << 32) | read4(p + shift);
+			b = (read4(p + size - 4) << 32) | read4(p + size - 4 - shift);
+		} else if(size > 0){
+			a = read3(p, size);
+		}
+	} else{
+		size_t rest = size;
+		if(rest > 48){
+			uint64_t seed1 = seed;
+			uint64_t seed2 = seed;
+			do{
+				seed = mix(read8(p) ^ kSecret[1], read8(p + 8) ^ seed);
+				seed1 = mix(read8(p + 16) ^ kSecret[2], read8(p + 24) ^ seed1);
+				seed2 = mix(read8(p + 32) ^ kSecret[3], read8(p + 40) ^ seed2);
+				p += 48;
+				rest -= 48;
+			} while(rest > 48);
+			seed ^= seed1 ^ seed2;
+		}
+		while(rest > 16){
+			seed = mix(read8(p) ^ kSecret[1], read8(p + 8) ^ seed);
+			p += 16;
+			rest -= 16;
+		}
+		a = read8(p + rest - 16);
+		b = read8(p + rest - 8);
+	}
+	a ^= kSecret[1];
+	b ^= seed;
+	__extension__ unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+	a = static_cast<uint64_t>(product);
+	b = static_cast<uint64_t>(product >> 64);
+	return mix(a ^ kSecret[0] ^ size, b ^ kSecret[1]);
+}
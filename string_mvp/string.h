@@ -1,15 +1,33 @@
 #pragma once
+#include <atomic>
 #include <iostream>
 #include <cstring>
+#include <functional>
+#include "hash.h"
+#include "utf8.h"
 
 class String{
 private:
 	char* str;
 	size_t sz;
 	size_t cap;
+	// hash() is computed on first use and kept until a mutator runs; writes through a
+	// reference or pointer obtained before the last hash() call are not noticed. Both fields
+	// are atomic so that concurrent hash() calls on a shared const String are safe: each
+	// stores the same value, and hash_valid is published after cached_hash.
+	mutable std::atomic<size_t> cached_hash{0};
+	mutable std::atomic<bool> hash_valid{false};
 	static constexpr size_t kDefaultCapacity = 8;
 	static constexpr size_t kCapacityExpansion = 2;
 
+	void forget_hash(){
+		hash_valid.store(false, std::memory_order_relaxed);
+	}
+
+	static bool is_space(char c){
+		return c == ' ' || (c >= '\t' && c <= '\r');
+	}
+
 public:
 	explicit String(const char* other) {
 		if(!other){cap = 1; sz = 0; str = new char[cap]; str[sz] = '\0'; return;}
@@ -33,10 +51,18 @@ public:
 		if(c == '\0'){sz = 0;}
 	}
 
-	String(const String& other): str(new char[other.cap]), sz(other.sz), cap(other.cap){
+	String(const String& other): str(new char[other.cap]), sz(other.sz), cap(other.cap),
+			cached_hash(other.cached_hash.load(std::memory_order_relaxed)),
+			hash_valid(other.hash_valid.load(std::memory_order_acquire)){
 		memcpy(str, other.str, sz + 1);
 	} 
 
+	// Leaves other as a default-constructed empty String, so it can still be read, copied and
+	// compared. Its one-byte buffer is the only allocation; failing it terminates.
+	String(String&& other) noexcept: String(){
+		swap(other);
+	}
+
 	~String(){
 		delete[] str;
 	}
@@ -45,6 +71,12 @@ public:
 		std::swap(str, other.str);
 		std::swap(sz, other.sz);
 		std::swap(cap, other.cap);
+		size_t other_hash = other.cached_hash.load(std::memory_order_relaxed);
+		bool other_valid = other.hash_valid.load(std::memory_order_relaxed);
+		other.cached_hash.store(cached_hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		other.hash_valid.store(hash_valid.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		cached_hash.store(other_hash, std::memory_order_relaxed);
+		hash_valid.store(other_valid, std::memory_order_relaxed);
 	}
 
 	String& operator=(String other) & {
@@ -52,8 +84,11 @@ public:
 		return *this;
 	}
 
+	// Byte-wise over all sz bytes, embedded '\0' included, so that equal Strings are exactly
+	// those with equal hash() input.
 	bool operator<(const String& other) const{
-		return strcmp(str, other.str) < 0;
+		int order = memcmp(str, other.str, sz < other.sz ? sz : other.sz);
+		return order < 0 || (order == 0 && sz < other.sz);
 	}
 
 	bool operator>(const String& other) const{
@@ -69,15 +104,16 @@ public:
 	}
 
 	bool operator==(const String& other) const{
-		return strcmp(str, other.str) == 0;
+		return sz == other.sz && memcmp(str, other.str, sz) == 0;
 	}
 
 	bool operator!=(const String& other) const{
-		return strcmp(str, other.str) != 0;
+		return !(*this == other);
 	}
 	
 
 	char& operator[](size_t n) {
+		forget_hash();
 		return str[n];
 	}
 
@@ -98,6 +134,7 @@ public:
 	}
 
 	void push_back(char c){
+		forget_hash();
 		if (cap == 0){
 			cap = kDefaultCapacity;
 			str = new char[cap];
@@ -113,10 +150,12 @@ public:
 	}
 
 	void pop_back(){
+		forget_hash();
 		str[--sz] = '\0';
 	}
 
 	char& front() {
+		forget_hash();
 		return str[0];
 	}
 
@@ -125,6 +164,7 @@ public:
 	}
 
 	char& back() {
+		forget_hash();
 		return str[sz-1];
 	}
 
@@ -138,6 +178,7 @@ public:
 	}
 
 	String& operator+=(const String& other){
+		forget_hash();
 		if (cap == 0){
 			cap = (kDefaultCapacity < other.sz + 1) ? other.sz + 1 : kDefaultCapacity;
 			str = new char[cap];
@@ -146,10 +187,13 @@ public:
 			cap = (cap * kCapacityExpansion < sz + other.sz + 1) ? sz + other.sz + 1 : cap * kCapacityExpansion;
 			char* new_str = new char[cap];
 			memcpy(new_str, str, sz);
+			memcpy(new_str + sz, other.str, other.sz + 1);
 			delete[] str;
 			str = new_str;
+		} else{
+			memmove(str + sz, other.str, other.sz + 1);
 		}
-		memcpy(str + sz, other.str, other.sz + 1);	
+		sz += other.sz;
 		return *this;
 	}
 
@@ -194,6 +238,7 @@ public:
 	}
 
 	void clear(){
+		forget_hash();
 		if(!str){return;}
 		str[0] = '\0';
 		sz = 0;
@@ -209,14 +254,64 @@ public:
 	}
 
 	char* data(){
+		forget_hash();
 		return str;
 	}
 
 	const char* data() const{
 		return str;
 	}
+
+	size_t hash() const{
+		if(!hash_valid.load(std::memory_order_acquire)){
+			cached_hash.store(static_cast<size_t>(hash_bytes(str, sz)), std::memory_order_relaxed);
+			hash_valid.store(true, std::memory_order_release);
+		}
+		return cached_hash.load(std::memory_order_relaxed);
+	}
+
+	bool is_valid_utf8() const{
+		return utf8_valid(str, sz);
+	}
+
+	// Number of code points, provided the string is valid UTF-8.
+	size_t codepoint_count() const{
+		return utf8_length(str, sz);
+	}
+
+	void to_lower_ascii(){
+		forget_hash();
+		ascii_to_lower(str, sz);
+	}
+
+	void to_upper_ascii(){
+		forget_hash();
+		ascii_to_upper(str, sz);
+	}
+
+	// Removes leading and trailing ASCII whitespace, keeping the buffer.
+	void trim(){
+		size_t end = sz;
+		while(end > 0 && is_space(str[end - 1])){--end;}
+		size_t begin = 0;
+		while(begin < end && is_space(str[begin])){++begin;}
+		if(begin == 0 && end == sz){return;}
+		forget_hash();
+		memmove(str, str + begin, end - begin);
+		sz = end - begin;
+		str[sz] = '\0';
+	}
 };
 
+namespace std{
+	template <>
+	struct hash<String>{
+		size_t operator()(const String& value) const noexcept{
+			return value.hash();
+		}
+	};
+}
+
 
 String operator""_str(const char* str, size_t){
 	return String(str);
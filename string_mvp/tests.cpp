@@ -1,7 +1,13 @@
 #include "string.h"
+#include "flat_hash_map.h"
 #include <gtest/gtest.h>
 #include <sstream>
 #include <limits>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 // ---------- Конструкторы ----------
 TEST(ConstructorTest, FromCString) {
@@ -48,6 +54,19 @@ TEST(ConstructorTest, DefaultConstructor) {
     EXPECT_TRUE(s.empty());
 }
 
+TEST(ConstructorTest, MovedFromIsEmpty) {
+    String a("moved away");
+    String b(std::move(a));
+    EXPECT_EQ(b, "moved away"_str);
+    String copy(a); // чтение после перемещения
+    EXPECT_EQ(copy, String());
+    EXPECT_EQ(a, String());
+    EXPECT_LT(a, b);
+    EXPECT_STREQ(a.data(), "");
+    a += "reused"_str;
+    EXPECT_EQ(a, "reused"_str);
+}
+
 // ---------- Операторы сравнения ----------
 TEST(OperatorTest, ComparisonEqual) {
     String a("abc"), b("abc");
@@ -120,6 +139,15 @@ TEST(OperatorTest, PlusEqualString) {
     EXPECT_STREQ(s1.data(), "abcdef");
 }
 
+TEST(OperatorTest, PlusEqualSizeAndSelf) {
+    String s("abc");
+    s += String("de");
+    EXPECT_EQ(s.size(), 5);
+    s += s;
+    EXPECT_EQ(s.size(), 10);
+    EXPECT_STREQ(s.data(), "abcdeabcde");
+}
+
 TEST(OperatorTest, PlusOperator) {
     String a("foo"), b("bar");
     String c = a + b;
@@ -226,4 +254,182 @@ TEST(BoundaryTest, OnlyNullChar) {
     String s("\0");
     EXPECT_EQ(s.size(), 0); // strlen("\0") == 0
     EXPECT_TRUE(s.empty());
-}
\ No newline at end of file
+}
+
+// ---------- Хеширование ----------
+TEST(HashTest, EqualStringsEqualHashes) {
+    String a("hash me");
+    String b;
+    for (char c : std::string("hash me")) b.push_back(c);
+    EXPECT_EQ(a.hash(), b.hash());
+    EXPECT_EQ(std::hash<String>()(a), a.hash());
+    EXPECT_NE(String("hash me").hash(), String("hash mf").hash());
+    EXPECT_EQ(a.hash(), static_cast<size_t>(hash_bytes("hash me", 7)));
+}
+
+TEST(HashTest, EmbeddedNullIsPartOfTheValue) {
+    String a("ab");
+    String b("ab");
+    b.push_back('\0');
+    String c("ab");
+    c.push_back('\0');
+    c.push_back('x');
+    EXPECT_NE(a, b);
+    EXPECT_NE(b, c);
+    EXPECT_TRUE(a < b && b < c);
+    EXPECT_FALSE(b < a);
+    EXPECT_NE(a.hash(), b.hash());
+    String d("ab");
+    d.push_back('\0');
+    EXPECT_EQ(b, d);
+    EXPECT_EQ(std::hash<String>()(b), std::hash<String>()(d));
+    std::unordered_set<String> set{a, b, c, d};
+    EXPECT_EQ(set.size(), 3);
+}
+
+TEST(HashTest, AllLengths) {
+    // every length class of the hash: empty, 1-3, 4-16, 17-48 and longer
+    std::unordered_set<size_t> seen;
+    std::string text;
+    for (size_t n = 0; n < 200; n++) {
+        EXPECT_EQ(String(text.c_str()).hash(), hash_bytes(text.data(), text.size()));
+        seen.insert(String(text.c_str()).hash());
+        text.push_back(static_cast<char>('a' + n % 26));
+    }
+    EXPECT_EQ(seen.size(), 200);
+}
+
+TEST(HashTest, CacheInvalidatedByMutators) {
+    String s("abc");
+    size_t h = s.hash();
+    s.push_back('d');
+    EXPECT_NE(s.hash(), h);
+    s.pop_back();
+    EXPECT_EQ(s.hash(), h);
+    s += 'x';
+    EXPECT_EQ(s.hash(), String("abcx").hash());
+    s += String("yz");
+    EXPECT_EQ(s.hash(), String("abcxyz").hash());
+    s[0] = 'z';
+    EXPECT_EQ(s.hash(), String("zbcxyz").hash());
+    s.data()[1] = 'z';
+    EXPECT_EQ(s.hash(), String("zzcxyz").hash());
+    s.clear();
+    EXPECT_EQ(s.hash(), String().hash());
+}
+
+TEST(HashTest, ConcurrentFirstHash) {
+    const String shared("hashed from several threads at once");
+    size_t expected = static_cast<size_t>(hash_bytes(shared.data(), shared.size()));
+    std::vector<std::thread> threads;
+    std::vector<size_t> results(4);
+    for (size_t i = 0; i < results.size(); i++) {
+        threads.emplace_back([&shared, &results, i] { results[i] = shared.hash(); });
+    }
+    for (std::thread& thread : threads) thread.join();
+    for (size_t result : results) EXPECT_EQ(result, expected);
+}
+
+TEST(HashTest, UnorderedContainers) {
+    std::unordered_map<String, int> counts;
+    std::istringstream words("a b a c b a");
+    String word;
+    while (words >> word) counts[word]++;
+    EXPECT_EQ(counts.size(), 3);
+    EXPECT_EQ(counts["a"_str], 3);
+    EXPECT_EQ(counts["c"_str], 1);
+}
+
+// ---------- FlatHashMap ----------
+TEST(FlatHashMapTest, InsertFind) {
+    FlatHashMap<int> map;
+    EXPECT_TRUE(map.insert("one"_str, 1).second);
+    EXPECT_FALSE(map.insert("one"_str, 10).second);
+    map["two"_str] = 2;
+    EXPECT_EQ(map.size(), 2);
+    ASSERT_NE(map.find("one"_str), nullptr);
+    EXPECT_EQ(*map.find("one"_str), 1);
+    EXPECT_EQ(*map.find("two"), 2);
+    EXPECT_EQ(map.find("three"), nullptr);
+    EXPECT_FALSE(map.contains(""_str));
+}
+
+TEST(FlatHashMapTest, GrowAndErase) {
+    FlatHashMap<size_t> map;
+    const size_t N = 5000;
+    for (size_t i = 0; i < N; i++) map[String(std::to_string(i).c_str())] = i;
+    EXPECT_EQ(map.size(), N);
+    for (size_t i = 0; i < N; i += 2) EXPECT_TRUE(map.erase(std::to_string(i).c_str()));
+    EXPECT_FALSE(map.erase("0"));
+    EXPECT_EQ(map.size(), N / 2);
+    for (size_t i = 0; i < N; i++) {
+        const size_t* value = map.find(std::to_string(i).c_str());
+        if (i % 2 == 0) {
+            EXPECT_EQ(value, nullptr);
+        } else {
+            ASSERT_NE(value, nullptr);
+            EXPECT_EQ(*value, i);
+        }
+    }
+    size_t sum = 0;
+    for (const auto& entry : map) sum += entry.second;
+    EXPECT_EQ(sum, (N / 2) * (N / 2));
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find("1"), nullptr);
+}
+
+// ---------- UTF-8 и ASCII ----------
+TEST(Utf8Test, Validation) {
+    EXPECT_TRUE(""_str.is_valid_utf8());
+    EXPECT_TRUE(String("héllo wörld ✓ 𝄞").is_valid_utf8());
+    EXPECT_FALSE(String("\xC0\xAF").is_valid_utf8());           // overlong
+    EXPECT_FALSE(String("\xED\xA0\x80").is_valid_utf8());       // surrogate
+    EXPECT_FALSE(String("\xF4\x90\x80\x80").is_valid_utf8());   // above U+10FFFF
+    EXPECT_FALSE(String("\x80").is_valid_utf8());               // lone continuation
+    // A cut sequence at every position relative to the 16- and 32-byte blocks.
+    for (size_t pad = 0; pad < 70; pad++) {
+        String text(pad, 'a');
+        text += String("\xF0\x9F\x98\x80");
+        EXPECT_TRUE(text.is_valid_utf8());
+        text.pop_back();
+        EXPECT_FALSE(text.is_valid_utf8());
+        text += "b"_str;
+        EXPECT_FALSE(text.is_valid_utf8());
+    }
+}
+
+TEST(Utf8Test, CodepointCount) {
+    EXPECT_EQ(""_str.codepoint_count(), 0);
+    String text("жук ✓ 𝄞");
+    EXPECT_EQ(text.size(), 15);
+    EXPECT_EQ(text.codepoint_count(), 7);
+    String repeated;
+    for (size_t i = 0; i < 1000; i++) repeated += "aé€"_str;
+    EXPECT_EQ(repeated.codepoint_count(), 3000);
+}
+
+TEST(Utf8Test, AsciiCaseMapping) {
+    String text("Hello, Мир! [@`{] ABCXYZ abcxyz 0123456789 Ünïcode");
+    text.to_lower_ascii();
+    EXPECT_STREQ(text.data(), "hello, Мир! [@`{] abcxyz abcxyz 0123456789 Ünïcode");
+    size_t before = text.hash();
+    text.to_upper_ascii();
+    EXPECT_STREQ(text.data(), "HELLO, Мир! [@`{] ABCXYZ ABCXYZ 0123456789 ÜNïCODE");
+    EXPECT_NE(text.hash(), before);
+}
+
+TEST(Utf8Test, Trim) {
+    String text(" \t\n middle  words \r\n");
+    size_t capacity = text.capacity();
+    text.trim();
+    EXPECT_STREQ(text.data(), "middle  words");
+    EXPECT_EQ(text.size(), 13);
+    EXPECT_EQ(text.capacity(), capacity);
+    String blank("  \t ");
+    blank.trim();
+    EXPECT_TRUE(blank.empty());
+    String kept("x");
+    kept.trim();
+    EXPECT_EQ(kept, "x"_str);
+}
@@ -0,0 +1,334 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+// UTF-8 validation, code point counting and ASCII case mapping over a byte range. On x86-64
+// the work is done 16 bytes at a time with SSE, or 32 with AVX2 when the CPU has it; the scalar
+// loops serve other targets. Validation follows Keiser and Lemire, "Validating UTF-8 In Less
+// Than One Instruction Per Byte": three 16-entry tables indexed by the high and low nibble of
+// the previous byte and the high nibble of the current one flag every invalid two-byte pattern,
+// and a saturating subtraction marks the bytes that must continue a three- or four-byte
+// sequence. Overlong forms, surrogates and code points above U+10FFFF are rejected.
+
+namespace utf8_detail{
+	// Error bits of a byte pair (previous, current).
+	static constexpr uint8_t kTooShort = 1 << 0;    // lead followed by a lead or by ASCII
+	static constexpr uint8_t kTooLong = 1 << 1;     // ASCII followed by a continuation
+	static constexpr uint8_t kOverlong3 = 1 << 2;   // 11100000 100xxxxx
+	static constexpr uint8_t kTooLarge = 1 << 3;    // 11110100 1001xxxx and above
+	static constexpr uint8_t kSurrogate = 1 << 4;   // 11101101 101xxxxx
+	static constexpr uint8_t kOverlong2 = 1 << 5;   // 1100000x 10xxxxxx
+	static constexpr uint8_t kTooLarge1000 = 1 << 6; // 11110101 1000xxxx and above
+	static constexpr uint8_t kOverlong4 = 1 << 6;   // 11110000 1000xxxx
+	static constexpr uint8_t kTwoConts = 1 << 7;    // continuation followed by a continuation
+	static constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+	alignas(16) static constexpr uint8_t kByte1High[16] = {
+		kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+		kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+		kTooShort | kOverlong2,
+		kTooShort,
+		kTooShort | kOverlong3 | kSurrogate,
+		kTooShort | kTooLarge | kTooLarge1000 | kOverlong4};
+
+	alignas(16) static constexpr uint8_t kByte1Low[16] = {
+		kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+		kCarry | kOverlong2,
+		kCarry,
+		kCarry,
+		kCarry | kTooLarge,
+		kCarry | kTooLarge | kTooLarge1000,
+		kCarry | kTooLarge | kTooLarge1000,
+		kCarry | kTooLarge | kTooLarge1000,
+		kCarry | kTooLarge | kTooLarge1000,
+		kCarry | kTooLarge | kTooLarge1000,
+		kCarry | kTooLarge | kTooLarge1000,
+		kCarry | kTooLarge | kTooLarge1000,
+		kCarry | kTooLarge | kTooLarge1000,
+		kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+		kCarry | kTooLarge | kTooLarge1000,
+		kCarry | kTooLarge | kTooLarge1000};
+
+	alignas(16) static constexpr uint8_t kByte2High[16] = {
+		kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+		kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+		kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+		kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+		kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+		kTooShort, kTooShort, kTooShort, kTooShort};
+
+	inline bool valid_scalar(const unsigned char* p, size_t size){
+		size_t i = 0;
+		while(i < size){
+			if(size - i >= 8){
+				uint64_t word;
+				memcpy(&word, p + i, 8);
+				if((word & 0x8080808080808080ULL) == 0){i += 8; continue;}
+			}
+			unsigned char lead = p[i];
+			if(lead < 0x80){++i; continue;}
+			size_t length;
+			uint32_t code_point;
+			uint32_t smallest;
+			if((lead & 0xE0) == 0xC0){length = 2; code_point = lead & 0x1Fu; smallest = 0x80;}
+			else if((lead & 0xF0) == 0xE0){length = 3; code_point = lead & 0x0Fu; smallest = 0x800;}
+			else if((lead & 0xF8) == 0xF0){length = 4; code_point = lead & 0x07u; smallest = 0x10000;}
+			else{return false;}
+			if(size - i < length){return false;}
+			for(size_t k = 1; k < length; ++k){
+				if((p[i + k] & 0xC0) != 0x80){return false;}
+				code_point = (code_point << 6) | (p[i + k] & 0x3Fu);
+			}
+			if(code_point < smallest || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF)){return false;}
+			i += length;
+		}
+		return true;
+	}
+
+	inline size_t count_scalar(const unsigned char* p, size_t size){
+		size_t count = 0;
+		for(size_t i = 0; i < size; ++i){
+			count += (p[i] & 0xC0) != 0x80;
+		}
+		return count;
+	}
+
+	// Flips bit 5 of every byte in [first, first + 26).
+	inline void flip_case_scalar(unsigned char* p, size_t size, unsigned char first){
+		for(size_t i = 0; i < size; ++i){
+			if(static_cast<unsigned char>(p[i] - first) < 26){p[i] ^= 0x20;}
+		}
+	}
+
+#ifdef __x86_64__
+	// The last three bytes of a block may only start a sequence that the next block completes.
+	static constexpr uint8_t kIncomplete[32] = {
+		255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+		255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1};
+
+	__attribute__((target("ssse3"))) inline __m128i block_errors_ssse3(__m128i input, __m128i previous){
+		const __m128i low_nibble = _mm_set1_epi8(0x0F);
+		__m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+		__m128i byte_1_high = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(kByte1High)),
+			_mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble));
+		__m128i byte_1_low = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(kByte1Low)),
+			_mm_and_si128(prev1, low_nibble));
+		__m128i byte_2_high = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(kByte2High)),
+			_mm_and_si128(_mm_srli_epi16(input, 4), low_nibble));
+		__m128i special = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+		// A continuation after a continuation is an error unless it is the third or fourth byte
+		// of a sequence; only leads 111xxxxx two back or 1111xxxx three back keep the high bit.
+		__m128i third = _mm_subs_epu8(_mm_alignr_epi8(input, previous, 14), _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+		__m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, previous, 13), _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+		__m128i must_continue = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(static_cast<char>(0x80)));
+		return _mm_xor_si128(must_continue, special);
+	}
+
+	// An all-ASCII block only has to check that the previous one did not end inside a sequence.
+	struct StateSsse3{
+		__m128i error;
+		__m128i previous;
+		__m128i previous_incomplete;
+	};
+
+	__attribute__((target("ssse3"))) inline void validate_block_ssse3(const unsigned char* block, StateSsse3& state){
+		__m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+		if(_mm_movemask_epi8(input) == 0){
+			state.error = _mm_or_si128(state.error, state.previous_incomplete);
+			state.previous_incomplete = _mm_setzero_si128();
+		} else{
+			state.error = _mm_or_si128(state.error, block_errors_ssse3(input, state.previous));
+			state.previous_incomplete = _mm_subs_epu8(input, _mm_loadu_si128(reinterpret_cast<const __m128i*>(kIncomplete + 16)));
+		}
+		state.previous = input;
+	}
+
+	// The input is followed by a zero-padded final block, so a sequence cut off at the end
+	// shows up as a lead followed by ASCII.
+	__attribute__((target("ssse3"))) inline bool valid_ssse3(const unsigned char* p, size_t size){
+		StateSsse3 state = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+		size_t i = 0;
+		for(; i + 16 <= size; i += 16){
+			validate_block_ssse3(p + i, state);
+		}
+		unsigned char last[16] = {};
+		if(size > i){memcpy(last, p + i, size - i);}
+		validate_block_ssse3(last, state);
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(state.error, _mm_setzero_si128())) == 0xFFFF;
+	}
+
+	__attribute__((target("avx2"))) inline __m256i broadcast_table(const uint8_t* values){
+		return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(values)));
+	}
+
+	__attribute__((target("avx2"))) inline __m256i block_errors_avx2(__m256i input, __m256i previous){
+		const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+		// alignr works within 128-bit lanes, so it is fed the upper half of previous and the
+		// lower half of input as its low operand.
+		__m256i straddle = _mm256_permute2x128_si256(previous, input, 0x21);
+		__m256i prev1 = _mm256_alignr_epi8(input, straddle, 15);
+		__m256i byte_1_high = _mm256_shuffle_epi8(broadcast_table(kByte1High), _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+		__m256i byte_1_low = _mm256_shuffle_epi8(broadcast_table(kByte1Low), _mm256_and_si256(prev1, low_nibble));
+		__m256i byte_2_high = _mm256_shuffle_epi8(broadcast_table(kByte2High), _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+		__m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+		__m256i third = _mm256_subs_epu8(_mm256_alignr_epi8(input, straddle, 14), _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+		__m256i fourth = _mm256_subs_epu8(_mm256_alignr_epi8(input, straddle, 13), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+		__m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+		return _mm256_xor_si256(must_continue, special);
+	}
+
+	struct StateAvx2{
+		__m256i error;
+		__m256i previous;
+		__m256i previous_incomplete;
+	};
+
+	__attribute__((target("avx2"))) inline void validate_block_avx2(const unsigned char* block, StateAvx2& state){
+		__m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+		if(_mm256_movemask_epi8(input) == 0){
+			state.error = _mm256_or_si256(state.error, state.previous_incomplete);
+			state.previous_incomplete = _mm256_setzero_si256();
+		} else{
+			state.error = _mm256_or_si256(state.error, block_errors_avx2(input, state.previous));
+			state.previous_incomplete = _mm256_subs_epu8(input, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kIncomplete)));
+		}
+		state.previous = input;
+	}
+
+	__attribute__((target("avx2"))) inline bool valid_avx2(const unsigned char* p, size_t size){
+		StateAvx2 state = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+		size_t i = 0;
+		for(; i + 32 <= size; i += 32){
+			validate_block_avx2(p + i, state);
+		}
+		unsigned char last[32] = {};
+		if(size > i){memcpy(last, p + i, size - i);}
+		validate_block_avx2(last, state);
+		return _mm256_testz_si256(state.error, state.error) != 0;
+	}
+
+	// Non-continuation bytes are counted in per-byte counters, which are summed with psadbw
+	// before they can wrap.
+	inline size_t count_sse2(const unsigned char* p, size_t size){
+		const __m128i last_continuation = _mm_set1_epi8(static_cast<char>(0xBF));
+		__m128i total = _mm_setzero_si128();
+		size_t i = 0;
+		while(size - i >= 16){
+			size_t blocks = (size - i) / 16 < 255 ? (size - i) / 16 : 255;
+			__m128i counters = _mm_setzero_si128();
+			for(size_t b = 0; b < blocks; ++b, i += 16){
+				__m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+				counters = _mm_sub_epi8(counters, _mm_cmpgt_epi8(input, last_continuation));
+			}
+			total = _mm_add_epi64(total, _mm_sad_epu8(counters, _mm_setzero_si128()));
+		}
+		uint64_t lanes[2];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), total);
+		return static_cast<size_t>(lanes[0] + lanes[1]) + count_scalar(p + i, size - i);
+	}
+
+	__attribute__((target("avx2"))) inline size_t count_avx2(const unsigned char* p, size_t size){
+		const __m256i last_continuation = _mm256_set1_epi8(static_cast<char>(0xBF));
+		__m256i total = _mm256_setzero_si256();
+		size_t i = 0;
+		while(size - i >= 32){
+			size_t blocks = (size - i) / 32 < 255 ? (size - i) / 32 : 255;
+			__m256i counters = _mm256_setzero_si256();
+			for(size_t b = 0; b < blocks; ++b, i += 32){
+				__m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+				counters = _mm256_sub_epi8(counters, _mm256_cmpgt_epi8(input, last_continuation));
+			}
+			total = _mm256_add_epi64(total, _mm256_sad_epu8(counters, _mm256_setzero_si256()));
+		}
+		uint64_t lanes[4];
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), total);
+		return static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]) + count_sse2(p + i, size - i);
+	}
+
+	// Bytes are biased so that [first, first + 26) lands on the bottom of the signed range,
+	// where one signed comparison finds it.
+	inline void flip_case_sse2(unsigned char* p, size_t size, unsigned char first){
+		const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80 - first));
+		const __m128i limit = _mm_set1_epi8(-128 + 26);
+		const __m128i flip = _mm_set1_epi8(0x20);
+		size_t i = 0;
+		for(; i + 16 <= size; i += 16){
+			__m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+			__m128i letters = _mm_cmpgt_epi8(limit, _mm_add_epi8(input, bias));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(p + i), _mm_xor_si128(input, _mm_and_si128(letters, flip)));
+		}
+		flip_case_scalar(p + i, size - i, first);
+	}
+
+	__attribute__((target("avx2"))) inline void flip_case_avx2(unsigned char* p, size_t size, unsigned char first){
+		const __m256i bias = _mm256_set1_epi8(static_cast<char>(0x80 - first));
+		const __m256i limit = _mm256_set1_epi8(-128 + 26);
+		const __m256i flip = _mm256_set1_epi8(0x20);
+		size_t i = 0;
+		for(; i + 32 <= size; i += 32){
+			__m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+			__m256i letters = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(input, bias));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(p + i), _mm256_xor_si256(input, _mm256_and_si256(letters, flip)));
+		}
+		flip_case_sse2(p + i, size - i, first);
+	}
+
+	enum class Level{kScalar, kSsse3, kAvx2};
+
+	inline Level level(){
+		static const Level detected = __builtin_cpu_supports("avx2") ? Level::kAvx2
+			: __builtin_cpu_supports("ssse3") ? Level::kSsse3 : Level::kScalar;
+		return detected;
+	}
+#endif
+
+	inline void flip_case(char* data, size_t size, unsigned char first){
+		unsigned char* p = reinterpret_cast<unsigned char*>(data);
+#ifdef __x86_64__
+		if(level() == Level::kAvx2){flip_case_avx2(p, size, first); return;}
+		flip_case_sse2(p, size, first);
+#else
+		flip_case_scalar(p, size, first);
+#endif
+	}
+}
+
+inline bool utf8_valid(const char* data, size_t size){
+	using namespace utf8_detail;
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+#ifdef __x86_64__
+	switch(level()){
+		case Level::kAvx2: return valid_avx2(p, size);
+		case Level::kSsse3: return valid_ssse3(p, size);
+		case Level::kScalar: break;
+	}
+#endif
+	return valid_scalar(p, size);
+}
+
+// Number of code points when the range is valid UTF-8: every byte but the continuations.
+inline size_t utf8_length(const char* data, size_t size){
+	using namespace utf8_detail;
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+#ifdef __x86_64__
+	if(level() == Level::kAvx2){return count_avx2(p, size);}
+	return count_sse2(p, size);
+#else
+	return count_scalar(p, size);
+#endif
+}
+
+// A-Z to a-z and back; every other byte, including UTF-8 sequences, is left alone.
+inline void ascii_to_lower(char* data, size_t size){
+	utf8_detail::flip_case(data, size, 'A');
+}
+
+inline void ascii_to_upper(char* data, size_t size){
+	utf8_detail::flip_case(data, size, 'a');
+}